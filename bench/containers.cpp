@@ -0,0 +1,178 @@
+/**
+ * @file containers.cpp
+ * @author The VLE Development Team
+ * See the AUTHORS or Authors.txt file
+ */
+
+/*
+ * Copyright (C) 2012 ULCO http://www.univ-littoral.fr
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Scans over the containers waiting in a transit zone: the search of the
+ * earliest exigibility date and the time-in-transit aggregate of the
+ * observations. The walk over a vector of Container pointers, in arrival
+ * order, is measured against the exigibility index of WaitingContainers
+ * for the search and against its running sum of the arrival dates for
+ * the aggregate.
+ */
+
+#include <Container.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+
+using namespace logistics;
+
+namespace {
+
+const unsigned int REPEAT = 20;
+
+double elapsed(const boost::posix_time::ptime& start)
+{
+    return (boost::posix_time::microsec_clock::universal_time() - start)
+        .total_microseconds() / 1000.;
+}
+
+Container* scanEarliest(const std::vector < Container* >& containers)
+{
+    Container* earliest = 0;
+
+    for (std::vector < Container* >::const_iterator it = containers.begin();
+         it != containers.end(); ++it) {
+        if (not earliest or
+            (*it)->exigibilityDate() < earliest->exigibilityDate()) {
+            earliest = *it;
+        }
+    }
+    return earliest;
+}
+
+double scanTimeInTransit(const std::vector < Container* >& containers,
+                         const Time& time)
+{
+    double t = 0;
+
+    for (std::vector < Container* >::const_iterator it = containers.begin();
+         it != containers.end(); ++it) {
+        double e = time - (*it)->arrivalDate();
+
+        if (e > 0) {
+            t += e;
+        }
+    }
+    return t;
+}
+
+} // anonymous namespace
+
+int main(int argc, char* argv[])
+{
+    std::vector < unsigned int > sizes;
+
+    for (int i = 1; i < argc; ++i) {
+        sizes.push_back(std::atoi(argv[i]));
+    }
+    if (sizes.empty()) {
+        sizes.push_back(10000);
+        sizes.push_back(100000);
+        sizes.push_back(1000000);
+    }
+
+    std::srand(545404204);
+    std::cout << std::setw(10) << "containers"
+              << std::setw(14) << "kernel"
+              << std::setw(14) << "scan (ms)"
+              << std::setw(16) << "store (ms)"
+              << std::setw(10) << "gain" << std::endl;
+
+    for (std::vector < unsigned int >::const_iterator it = sizes.begin();
+         it != sizes.end(); ++it) {
+        std::vector < Container* > arrivals;
+        WaitingContainers waiting;
+        LocationID source = Locations::id("Platform1");
+        LocationID destination = Locations::id("Platform2");
+
+        // containers are allocated in generation order but arrive in
+        // another one, as they do through the routers
+        for (unsigned int i = 0; i < *it; ++i) {
+            Container* container = new Container(
+                i, source, destination, i % 2 ? FOOD : NOFOOD,
+                std::rand() % 100000 / 100.);
+
+            container->arrived(std::rand() % 100000 / 100.);
+            arrivals.push_back(container);
+        }
+        std::random_shuffle(arrivals.begin(), arrivals.end());
+        for (unsigned int i = 0; i < *it; ++i) {
+            waiting.add(arrivals[i]);
+        }
+
+        boost::posix_time::ptime start =
+            boost::posix_time::microsec_clock::universal_time();
+        Container* earliest = 0;
+
+        for (unsigned int i = 0; i < REPEAT; ++i) {
+            earliest = scanEarliest(arrivals);
+        }
+
+        double s = elapsed(start);
+
+        start = boost::posix_time::microsec_clock::universal_time();
+        for (unsigned int i = 0; i < REPEAT; ++i) {
+            Container* container = waiting.pop();
+
+            if (i == 0 and
+                container->exigibilityDate() != earliest->exigibilityDate()) {
+                std::cerr << "earliest: inconsistent result" << std::endl;
+            }
+            waiting.add(container);
+        }
+
+        double c = elapsed(start);
+
+        std::cout << std::setw(10) << *it << std::setw(14) << "earliest"
+                  << std::setw(14) << s / REPEAT
+                  << std::setw(16) << c / REPEAT << std::setw(10)
+                  << (c > 0 ? s / c : 0) << std::endl;
+
+        double ts = 0;
+        double tc = 0;
+
+        start = boost::posix_time::microsec_clock::universal_time();
+        for (unsigned int i = 0; i < REPEAT; ++i) {
+            ts += scanTimeInTransit(arrivals, 1000. + i);
+        }
+        s = elapsed(start);
+        start = boost::posix_time::microsec_clock::universal_time();
+        for (unsigned int i = 0; i < REPEAT; ++i) {
+            tc += waiting.timeInTransit(1000. + i);
+        }
+        c = elapsed(start);
+        if (std::abs(ts - tc) > 1e-6 * ts) {
+            std::cerr << "time-in-transit: inconsistent result" << std::endl;
+        }
+
+        std::cout << std::setw(10) << *it << std::setw(14) << "in-transit"
+                  << std::setw(14) << s / REPEAT
+                  << std::setw(16) << c / REPEAT << std::setw(10)
+                  << (c > 0 ? s / c : 0) << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,670 @@
+/**
+ * @file dynamics.cpp
+ * @author The VLE Development Team
+ * See the AUTHORS or Authors.txt file
+ */
+
+/*
+ * Copyright (C) 2012 ULCO http://www.univ-littoral.fr
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Each dynamics of the package run alone: a minimal driver plays the
+ * part of the kernel, feeding synthetic event lists to the external
+ * transitions, running the internal transitions when they are due and
+ * discarding the outputs. The input events of a run are built before it
+ * is timed. For each dynamics and queue size, the transitions per
+ * second, the time and the heap allocations per event (input or output)
+ * are reported on the standard output and written as JSON.
+ *
+ *     dynamicsbench [-o results.json] [queue sizes...]
+ */
+
+#include <vle/devs/Dynamics.hpp>
+#include <vle/graph/AtomicModel.hpp>
+#include <vle/graph/CoupledModel.hpp>
+#include <Payload.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <new>
+
+namespace {
+
+unsigned long allocations = 0;
+bool counting = false;
+
+} // anonymous namespace
+
+void* operator new(std::size_t size)
+{
+    void* p = std::malloc(size ? size : 1);
+
+    if (not p) {
+        throw std::bad_alloc();
+    }
+    if (counting) {
+        ++allocations;
+    }
+    return p;
+}
+
+/*
+ * GCC warns of a free() of memory from new once a replacement operator
+ * delete is inlined into a delete expression; these are malloc-based on
+ * purpose, so they are kept out of line.
+ */
+#ifdef __GNUC__
+#define BENCH_NOINLINE __attribute__((noinline))
+#else
+#define BENCH_NOINLINE
+#endif
+
+BENCH_NOINLINE void operator delete(void* p)
+{
+    std::free(p);
+}
+
+#ifdef __cpp_sized_deallocation
+BENCH_NOINLINE void operator delete(void* p, std::size_t /* size */)
+{
+    operator delete(p);
+}
+#endif
+
+extern "C" {
+vle::devs::Dynamics* makeNewDynamicsDecision(
+    const vle::devs::DynamicsInit&, const vle::devs::InitEventList&);
+vle::devs::Dynamics* makeNewDynamicsDispatch(
+    const vle::devs::DynamicsInit&, const vle::devs::InitEventList&);
+vle::devs::Dynamics* makeNewDynamicsEntryDispatch(
+    const vle::devs::DynamicsInit&, const vle::devs::InitEventList&);
+vle::devs::Dynamics* makeNewDynamicsMove(
+    const vle::devs::DynamicsInit&, const vle::devs::InitEventList&);
+vle::devs::Dynamics* makeNewDynamicsSplit(
+    const vle::devs::DynamicsInit&, const vle::devs::InitEventList&);
+vle::devs::Dynamics* makeNewDynamicsTransit(
+    const vle::devs::DynamicsInit&, const vle::devs::InitEventList&);
+vle::devs::Dynamics* makeNewDynamicsTransitDestination(
+    const vle::devs::DynamicsInit&, const vle::devs::InitEventList&);
+vle::devs::Dynamics* makeNewDynamicsTransitFifo(
+    const vle::devs::DynamicsInit&, const vle::devs::InitEventList&);
+vle::devs::Dynamics* makeNewDynamicsTransitLateness(
+    const vle::devs::DynamicsInit&, const vle::devs::InitEventList&);
+vle::devs::Dynamics* makeNewDynamicsTransportGenerator(
+    const vle::devs::DynamicsInit&, const vle::devs::InitEventList&);
+}
+
+using namespace logistics;
+
+namespace {
+
+typedef vle::devs::Dynamics* (*Factory)(const vle::devs::DynamicsInit&,
+                                        const vle::devs::InitEventList&);
+
+/**
+ * Input events of a run, by date.
+ */
+typedef std::vector < std::pair < double, vle::devs::ExternalEventList* > >
+Inputs;
+
+/**
+ * One dynamics in its own coupled model, hence its own Simulation
+ * context, driven as the kernel would.
+ */
+class Driver
+{
+public:
+    Driver(const std::string& name, Factory factory,
+           vle::value::Map& conditions) :
+        mRoot("bench", 0), mModel(name, &mRoot), mTransitions(0),
+        mEvents(0)
+    {
+        conditions.addString("log-level", "quiet");
+
+        vle::devs::DynamicsInit init(mModel, mPackage);
+
+        mDynamics = factory(init, conditions);
+        mNext = mDynamics->init(0.);
+    }
+
+    ~Driver()
+    {
+        delete mDynamics;
+    }
+
+    /**
+     * Run the internal transitions due until time included.
+     */
+    void advance(double time)
+    {
+        while (mNext.getValue() <= time) {
+            vle::devs::ExternalEventList output;
+            vle::devs::Time now = mNext;
+
+            mDynamics->output(now, output);
+            mEvents += output.size();
+            output.deleteAndClear();
+            mDynamics->internalTransition(now);
+            mNext = now + mDynamics->timeAdvance();
+            ++mTransitions;
+        }
+    }
+
+    void external(double time, vle::devs::ExternalEventList& events)
+    {
+        advance(time);
+        mEvents += events.size();
+        mDynamics->externalTransition(events, time);
+        events.deleteAndClear();
+        mNext = time + mDynamics->timeAdvance().getValue();
+        ++mTransitions;
+    }
+
+    void play(Inputs& inputs)
+    {
+        for (Inputs::iterator it = inputs.begin(); it != inputs.end(); ++it) {
+            external(it->first, *it->second);
+            delete it->second;
+        }
+        inputs.clear();
+    }
+
+    void reset()
+    {
+        mTransitions = 0;
+        mEvents = 0;
+    }
+
+    unsigned long transitions() const
+    { return mTransitions; }
+
+    unsigned long events() const
+    { return mEvents; }
+
+private:
+    vle::graph::CoupledModel mRoot;
+    vle::graph::AtomicModel mModel;
+    vle::utils::PackageId mPackage;
+    vle::devs::Dynamics* mDynamics;
+    vle::devs::Time mNext;
+    unsigned long mTransitions;
+    unsigned long mEvents;
+};
+
+struct Result
+{
+    std::string dynamics;
+    unsigned int queue;
+    unsigned int rounds;
+    unsigned long transitions;
+    unsigned long events;
+    unsigned long allocations;
+    double seconds;
+};
+
+const char* PLATFORMS[] = { "Platform2", "Platform3", "Platform4",
+                            "Platform5" };
+
+TransportHandle transport(TransportID id, TransportType type,
+                          unsigned int capacity, ContentType content,
+                          double departure)
+{
+    return TransportHandle(new Transport(id, type, capacity,
+                                         Locations::id(PLATFORMS[id % 4]),
+                                         content, departure));
+}
+
+ContainerHandle container(ContainerID id, ContentType content)
+{
+    return ContainerHandle(new Container(id, Locations::id("A"),
+                                         Locations::id(PLATFORMS[id % 4]),
+                                         content, 20. + id % 80));
+}
+
+ContainersPayload* manifest(ContainerID first, unsigned int size)
+{
+    SharedContainers* containers = new SharedContainers;
+
+    for (unsigned int i = 0; i < size; ++i) {
+        containers->push_back(container(first + i, (ContentType)(i % 2)));
+    }
+    return new ContainersPayload(
+        ContainersPayload::handle_type(containers));
+}
+
+/**
+ * Batch of size containers of one type, as Split sends them in batch
+ * mode.
+ */
+vle::devs::ExternalEvent* batch(ContainerID first, unsigned int size,
+                                ContentType content)
+{
+    vle::devs::ExternalEvent* ee = new vle::devs::ExternalEvent("container");
+    SharedContainers* containers = new SharedContainers;
+
+    for (unsigned int i = 0; i < size; ++i) {
+        containers->push_back(container(first + i, content));
+    }
+    ee << vle::devs::attribute(
+        "containers", new ContainersPayload(
+            ContainersPayload::handle_type(containers)));
+    ee << vle::devs::attribute("type", (int)content);
+    return ee;
+}
+
+vle::devs::ExternalEventList* list()
+{
+    return new vle::devs::ExternalEventList;
+}
+
+vle::devs::ExternalEvent* event(const std::string& port)
+{
+    return new vle::devs::ExternalEvent(port);
+}
+
+/*
+ * Workloads: setup() feeds the untimed part, inputs() the timed one.
+ * queue is the size that matters to each dynamics: the waiting
+ * containers of Transit, the scheduled transports of Decision, the
+ * events per list of the routers, the manifest size of Split and of the
+ * generated transports.
+ */
+
+void routerInputs(const std::string& port, unsigned int queue,
+                  unsigned int rounds, Inputs& inputs)
+{
+    for (unsigned int r = 0; r < rounds; ++r) {
+        vle::devs::ExternalEventList* events = list();
+
+        for (unsigned int i = 0; i < queue; ++i) {
+            TransportID id = r * queue + i;
+            vle::devs::ExternalEvent* ee = event(port);
+
+            ee << vle::devs::attribute(
+                "transport", new TransportPayload(
+                    transport(id, (TransportType)(id % 3), 1,
+                              (ContentType)(id % 2), r + 10.)));
+            ee << vle::devs::attribute("containers", manifest(id, 1));
+            events->addEvent(ee);
+        }
+        inputs.push_back(std::make_pair((double)r, events));
+    }
+}
+
+void entryDispatch(Driver&, unsigned int queue, unsigned int rounds,
+                   Inputs& inputs)
+{
+    routerInputs("in", queue, rounds, inputs);
+}
+
+void move(Driver&, unsigned int queue, unsigned int rounds, Inputs& inputs)
+{
+    routerInputs("in", queue, rounds, inputs);
+}
+
+/*
+ * Dispatch receives queue containers each round, one per event or, in
+ * batch mode, in one event per content type.
+ */
+void dispatchInputs(unsigned int queue, unsigned int rounds, bool batched,
+                    Inputs& inputs)
+{
+    for (unsigned int r = 0; r < rounds; ++r) {
+        vle::devs::ExternalEventList* events = list();
+
+        if (batched) {
+            events->addEvent(batch(r * queue, queue / 2, FOOD));
+            events->addEvent(batch(r * queue + queue / 2,
+                                   queue - queue / 2, NOFOOD));
+        } else {
+            for (unsigned int i = 0; i < queue; ++i) {
+                vle::devs::ExternalEvent* ee = event("container");
+
+                ee << vle::devs::attribute(
+                    "container", new ContainerPayload(
+                        container(r * queue + i, (ContentType)(i % 2))));
+                events->addEvent(ee);
+            }
+        }
+
+        vle::devs::ExternalEvent* load = event("load");
+        vle::devs::ExternalEvent* depart = event("depart");
+
+        load << vle::devs::attribute("type", (int)(r % 2));
+        load << vle::devs::attribute(
+            "transport", new TransportPayload(
+                transport(r, TRUCK, 1, (ContentType)(r % 2), r + 10.)));
+        depart << vle::devs::attribute("type", (int)(r % 2));
+        depart << vle::devs::attribute("id", (int)r);
+        events->addEvent(load);
+        events->addEvent(depart);
+        inputs.push_back(std::make_pair((double)r, events));
+    }
+}
+
+void dispatch(Driver&, unsigned int queue, unsigned int rounds,
+              Inputs& inputs)
+{
+    dispatchInputs(queue, rounds, false, inputs);
+}
+
+void dispatchBatch(Driver&, unsigned int queue, unsigned int rounds,
+                   Inputs& inputs)
+{
+    dispatchInputs(queue, rounds, true, inputs);
+}
+
+void split(Driver&, unsigned int queue, unsigned int rounds, Inputs& inputs)
+{
+    for (unsigned int r = 0; r < rounds; ++r) {
+        vle::devs::ExternalEventList* events = list();
+        vle::devs::ExternalEvent* ee = event("in");
+
+        ee << vle::devs::attribute("containers", manifest(r * queue, queue));
+        events->addEvent(ee);
+        inputs.push_back(std::make_pair((double)r, events));
+    }
+}
+
+/*
+ * Transit holds queue containers; each round, a transport of capacity
+ * CAPACITY docks with as many new containers, is loaded, then departs.
+ * Containers and transports go to four destinations in turn. The
+ * variants of Transit, one per loading policy, run the same workload;
+ * in batch mode, the new containers of a round come in one event.
+ */
+const unsigned int CAPACITY = 10;
+
+void transitInputs(Driver& driver, unsigned int queue, unsigned int rounds,
+                   bool batched, Inputs& inputs)
+{
+    Inputs setup;
+    vle::devs::ExternalEventList* events = list();
+
+    for (unsigned int i = 0; i < queue; ++i) {
+        vle::devs::ExternalEvent* ee = event("container");
+
+        ee << vle::devs::attribute("container", new ContainerPayload(
+                                       container(i, FOOD)));
+        events->addEvent(ee);
+    }
+    setup.push_back(std::make_pair(0., events));
+    driver.play(setup);
+
+    for (unsigned int r = 1; r <= rounds; ++r) {
+        vle::devs::ExternalEvent* load = event("load");
+        vle::devs::ExternalEvent* depart = event("depart");
+
+        events = list();
+        load << vle::devs::attribute(
+            "transport", new TransportPayload(
+                transport(r, TRUCK, CAPACITY, FOOD, r + .5)));
+        events->addEvent(load);
+        if (batched) {
+            events->addEvent(batch(queue + r * CAPACITY, CAPACITY, FOOD));
+        } else {
+            for (unsigned int i = 0; i < CAPACITY; ++i) {
+                vle::devs::ExternalEvent* ee = event("container");
+
+                ee << vle::devs::attribute(
+                    "container", new ContainerPayload(
+                        container(queue + r * CAPACITY + i, FOOD)));
+                events->addEvent(ee);
+            }
+        }
+        inputs.push_back(std::make_pair((double)r, events));
+
+        events = list();
+        depart << vle::devs::attribute("id", (int)r);
+        events->addEvent(depart);
+        inputs.push_back(std::make_pair(r + .5, events));
+    }
+}
+
+void transit(Driver& driver, unsigned int queue, unsigned int rounds,
+             Inputs& inputs)
+{
+    transitInputs(driver, queue, rounds, false, inputs);
+}
+
+void transitBatch(Driver& driver, unsigned int queue, unsigned int rounds,
+                  Inputs& inputs)
+{
+    transitInputs(driver, queue, rounds, true, inputs);
+}
+
+/*
+ * Decision schedules queue transports, one departing at each integer
+ * date; each departure is loaded a quarter later, and replaced by a
+ * transport departing queue dates later.
+ */
+void decision(Driver& driver, unsigned int queue, unsigned int rounds,
+              Inputs& inputs)
+{
+    Inputs setup;
+    vle::devs::ExternalEventList* events = list();
+
+    for (unsigned int i = 1; i <= queue; ++i) {
+        vle::devs::ExternalEvent* ee = event("transport");
+
+        ee << vle::devs::attribute("transport", new TransportPayload(
+                                       transport(i, TRUCK, 1, FOOD, i)));
+        events->addEvent(ee);
+    }
+    setup.push_back(std::make_pair(0., events));
+    driver.play(setup);
+
+    for (unsigned int r = 1; r <= rounds; ++r) {
+        vle::devs::ExternalEvent* loaded = event("loaded");
+        vle::devs::ExternalEvent* ee = event("transport");
+
+        events = list();
+        loaded << vle::devs::attribute("id", (int)r);
+        events->addEvent(loaded);
+        inputs.push_back(std::make_pair(r + .25, events));
+
+        events = list();
+        ee << vle::devs::attribute(
+            "transport", new TransportPayload(
+                transport(queue + r, TRUCK, 1, FOOD, queue + r)));
+        events->addEvent(ee);
+        inputs.push_back(std::make_pair(r + .5, events));
+    }
+}
+
+typedef void (*Workload)(Driver&, unsigned int, unsigned int, Inputs&);
+
+typedef vle::value::Map (*Conditions)(unsigned int);
+
+struct Bench
+{
+    const char* name;
+    Factory factory;
+    Workload workload;
+    Conditions conditions;
+};
+
+vle::value::Map generatorConditions(unsigned int queue)
+{
+    vle::value::Map conditions;
+    vle::value::Set* destinations = new vle::value::Set;
+
+    for (unsigned int i = 0; i < 4; ++i) {
+        destinations->addString(PLATFORMS[i]);
+    }
+    conditions.addBoolean("ContainerPresent", true);
+    conditions.addInt("TransportType", TRUCK);
+    conditions.addInt("MinCapacity", queue);
+    conditions.addInt("MaxCapacity", queue);
+    conditions.addDouble("MinDuration", 1.);
+    conditions.addDouble("MaxDuration", 1.);
+    conditions.addDouble("MinStayDuration", 10.);
+    conditions.addDouble("MaxStayDuration", 10.);
+    conditions.add("Destinations", destinations);
+    conditions.addInt("MinSize", queue);
+    conditions.addDouble("MinTravelDuration", 20.);
+    conditions.addDouble("MaxTravelDuration", 100.);
+    return conditions;
+}
+
+vle::value::Map batchConditions(unsigned int /* queue */)
+{
+    vle::value::Map conditions;
+
+    conditions.addBoolean("Batch", true);
+    return conditions;
+}
+
+Result measure(const Bench& bench, unsigned int queue)
+{
+    // about the same number of events whatever the queue size
+    unsigned int rounds = std::max(20u, 100000u / queue);
+    bool generator = bench.factory == makeNewDynamicsTransportGenerator;
+    vle::value::Map conditions = bench.conditions ?
+        bench.conditions(queue) : vle::value::Map();
+    Driver driver(bench.name, bench.factory, conditions);
+    Inputs inputs;
+    Result result;
+
+    if (bench.workload) {
+        bench.workload(driver, queue, rounds, inputs);
+    }
+    driver.reset();
+    allocations = 0;
+    counting = true;
+
+    boost::posix_time::ptime start =
+        boost::posix_time::microsec_clock::universal_time();
+
+    if (generator) {
+        driver.advance(rounds);
+    } else {
+        driver.play(inputs);
+        driver.advance(rounds + 1.);
+    }
+
+    boost::posix_time::time_duration elapsed =
+        boost::posix_time::microsec_clock::universal_time() - start;
+
+    counting = false;
+    result.dynamics = bench.name;
+    result.queue = queue;
+    result.rounds = rounds;
+    result.transitions = driver.transitions();
+    result.events = driver.events();
+    result.allocations = allocations;
+    result.seconds = elapsed.total_microseconds() / 1e6;
+    return result;
+}
+
+void json(std::ostream& out, const std::vector < Result >& results)
+{
+    out << "{\n  \"benchmark\": \"dynamics\",\n  \"results\": [";
+    for (std::vector < Result >::const_iterator it = results.begin();
+         it != results.end(); ++it) {
+        out << (it == results.begin() ? "\n" : ",\n")
+            << "    { \"dynamics\": \"" << it->dynamics << "\""
+            << ", \"queue\": " << it->queue
+            << ", \"rounds\": " << it->rounds
+            << ", \"transitions\": " << it->transitions
+            << ", \"events\": " << it->events
+            << ", \"allocations\": " << it->allocations
+            << ", \"seconds\": " << it->seconds
+            << ", \"transitions_per_second\": "
+            << (it->seconds > 0 ? it->transitions / it->seconds : 0)
+            << ", \"ns_per_event\": "
+            << (it->events ? it->seconds * 1e9 / it->events : 0)
+            << ", \"allocations_per_event\": "
+            << (it->events ? (double)it->allocations / it->events : 0)
+            << " }";
+    }
+    out << "\n  ]\n}\n";
+}
+
+} // anonymous namespace
+
+int main(int argc, char* argv[])
+{
+    const Bench benches[] = {
+        { "Decision", makeNewDynamicsDecision, decision, 0 },
+        { "Dispatch", makeNewDynamicsDispatch, dispatch, 0 },
+        { "DispatchBatch", makeNewDynamicsDispatch, dispatchBatch, 0 },
+        { "EntryDispatch", makeNewDynamicsEntryDispatch, entryDispatch, 0 },
+        { "Move", makeNewDynamicsMove, move, 0 },
+        { "Split", makeNewDynamicsSplit, split, 0 },
+        { "SplitBatch", makeNewDynamicsSplit, split, batchConditions },
+        { "Transit", makeNewDynamicsTransit, transit, 0 },
+        { "TransitBatch", makeNewDynamicsTransit, transitBatch, 0 },
+        { "TransitDestination", makeNewDynamicsTransitDestination, transit,
+          0 },
+        { "TransitFifo", makeNewDynamicsTransitFifo, transit, 0 },
+        { "TransitLateness", makeNewDynamicsTransitLateness, transit, 0 },
+        { "TransportGenerator", makeNewDynamicsTransportGenerator, 0,
+          generatorConditions }
+    };
+    std::string output = "dynamics.json";
+    std::vector < unsigned int > sizes;
+    std::vector < Result > results;
+
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "-o") == 0 and i + 1 < argc) {
+            output = argv[++i];
+        } else {
+            sizes.push_back(std::atoi(argv[i]));
+        }
+    }
+    if (sizes.empty()) {
+        sizes.push_back(10);
+        sizes.push_back(100);
+        sizes.push_back(1000);
+        sizes.push_back(10000);
+    }
+
+    std::cout << std::setw(20) << "dynamics" << std::setw(8) << "queue"
+              << std::setw(16) << "transitions/s" << std::setw(12)
+              << "ns/event" << std::setw(14) << "allocs/event" << std::endl;
+
+    for (unsigned int b = 0; b < sizeof(benches) / sizeof(Bench); ++b) {
+        for (std::vector < unsigned int >::const_iterator it =
+                 sizes.begin(); it != sizes.end(); ++it) {
+            Result r = measure(benches[b], *it);
+
+            results.push_back(r);
+            std::cout << std::setw(20) << r.dynamics << std::setw(8)
+                      << r.queue << std::setw(16)
+                      << (unsigned long)(r.seconds > 0 ?
+                                         r.transitions / r.seconds : 0)
+                      << std::setw(12)
+                      << (r.events ? r.seconds * 1e9 / r.events : 0)
+                      << std::setw(14)
+                      << (r.events ? (double)r.allocations / r.events : 0)
+                      << std::endl;
+        }
+    }
+
+    std::ofstream file(output.c_str());
+
+    json(file, results);
+    if (not file) {
+        std::cerr << "cannot write " << output << std::endl;
+        return 1;
+    }
+    return 0;
+}
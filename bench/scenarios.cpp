@@ -0,0 +1,225 @@
+/**
+ * @file scenarios.cpp
+ * @author The VLE Development Team
+ * See the AUTHORS or Authors.txt file
+ */
+
+/*
+ * Copyright (C) 2012 ULCO http://www.univ-littoral.fr
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * End-to-end throughput: generated scenarios (see Scenario.hpp) of
+ * growing size and horizon, each simulated by the vle command (or the
+ * program named by the VLE environment variable) in a child process.
+ * The wall time covers the whole run, loading of the experiment
+ * included; the events are the external events received by the models
+ * of the package, which each simulation reports when it ends; the peak
+ * resident set size is the child's.
+ *
+ *     scenariosbench [-o results.json] [-p 3,10,50,100] [-d 100,1000]
+ *                    [-i intensity]
+ */
+
+#include <Scenario.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <sys/resource.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace logistics;
+
+namespace {
+
+struct Result
+{
+    unsigned int platforms;
+    double horizon;
+    unsigned long events;
+    double seconds;
+    long rss;
+    bool failed;
+};
+
+std::vector < double > list(const char* values)
+{
+    std::vector < double > result;
+    std::istringstream in(values);
+    std::string value;
+
+    while (std::getline(in, value, ',')) {
+        result.push_back(std::atof(value.c_str()));
+    }
+    return result;
+}
+
+/*
+ * Sum of the "[model] N events received" lines of the simulations.
+ */
+unsigned long events(std::FILE* output)
+{
+    unsigned long total = 0;
+    char line[4096];
+
+    while (std::fgets(line, sizeof(line), output)) {
+        const char* end = std::strstr(line, " events received");
+        const char* start = std::strstr(line, "] ");
+
+        if (end and start and start < end) {
+            total += std::strtoul(start + 2, 0, 10);
+        }
+    }
+    return total;
+}
+
+Result run(const std::string& vle, const std::string& path,
+           unsigned int platforms, double horizon)
+{
+    Result result;
+    int channel[2];
+
+    result.platforms = platforms;
+    result.horizon = horizon;
+    result.events = 0;
+    result.rss = 0;
+    result.failed = true;
+
+    if (::pipe(channel)) {
+        std::perror("pipe");
+        return result;
+    }
+
+    boost::posix_time::ptime start =
+        boost::posix_time::microsec_clock::universal_time();
+    pid_t pid = ::fork();
+
+    if (pid == 0) {
+        ::dup2(channel[1], STDOUT_FILENO);
+        ::close(channel[0]);
+        ::close(channel[1]);
+        ::setenv("LOGISTICS_LOG_LEVEL", "quiet", 1);
+        ::execlp(vle.c_str(), vle.c_str(), path.c_str(), (char*)0);
+        std::perror(vle.c_str());
+        ::_exit(127);
+    }
+    ::close(channel[1]);
+    if (pid < 0) {
+        std::perror("fork");
+        ::close(channel[0]);
+        return result;
+    }
+
+    std::FILE* output = ::fdopen(channel[0], "r");
+    struct rusage usage;
+    int status;
+
+    result.events = events(output);
+    std::fclose(output);
+    ::wait4(pid, &status, 0, &usage);
+    result.seconds = (boost::posix_time::microsec_clock::universal_time() -
+                      start).total_microseconds() / 1e6;
+    result.rss = usage.ru_maxrss;
+    result.failed = not WIFEXITED(status) or WEXITSTATUS(status) != 0;
+    return result;
+}
+
+void json(std::ostream& out, const std::vector < Result >& results)
+{
+    out << "{\n  \"benchmark\": \"scenarios\",\n  \"results\": [";
+    for (std::vector < Result >::const_iterator it = results.begin();
+         it != results.end(); ++it) {
+        out << (it == results.begin() ? "\n" : ",\n")
+            << "    { \"platforms\": " << it->platforms
+            << ", \"horizon\": " << it->horizon
+            << ", \"failed\": " << (it->failed ? "true" : "false")
+            << ", \"seconds\": " << it->seconds
+            << ", \"events\": " << it->events
+            << ", \"events_per_second\": "
+            << (it->seconds > 0 ? it->events / it->seconds : 0)
+            << ", \"peak_rss_kb\": " << it->rss << " }";
+    }
+    out << "\n  ]\n}\n";
+}
+
+} // anonymous namespace
+
+int main(int argc, char* argv[])
+{
+    std::string output = "scenarios.json";
+    std::vector < double > platforms = list("3,10,50,100");
+    std::vector < double > horizons = list("100,1000");
+    double intensity = 1.;
+    const char* vle = std::getenv("VLE");
+    std::vector < Result > results;
+
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (std::strcmp(argv[i], "-o") == 0) {
+            output = argv[i + 1];
+        } else if (std::strcmp(argv[i], "-p") == 0) {
+            platforms = list(argv[i + 1]);
+        } else if (std::strcmp(argv[i], "-d") == 0) {
+            horizons = list(argv[i + 1]);
+        } else if (std::strcmp(argv[i], "-i") == 0) {
+            intensity = std::atof(argv[i + 1]);
+        }
+    }
+
+    std::cout << std::setw(10) << "platforms" << std::setw(10) << "horizon"
+              << std::setw(12) << "seconds" << std::setw(14) << "events"
+              << std::setw(14) << "events/s" << std::setw(14)
+              << "peak RSS kB" << std::endl;
+
+    for (unsigned int p = 0; p < platforms.size(); ++p) {
+        for (unsigned int h = 0; h < horizons.size(); ++h) {
+            std::ostringstream path;
+            Scenario scenario(platforms[p]);
+
+            path << "scenario-" << platforms[p] << "-" << horizons[h]
+                 << ".vpz";
+            scenario.intensity(intensity);
+            scenario.duration(horizons[h]);
+            scenario.save(path.str());
+
+            Result r = run(vle ? vle : "vle", path.str(), platforms[p],
+                           horizons[h]);
+
+            results.push_back(r);
+            std::remove(path.str().c_str());
+            std::cout << std::setw(10) << r.platforms << std::setw(10)
+                      << r.horizon << std::setw(12) << r.seconds
+                      << std::setw(14) << r.events << std::setw(14)
+                      << (unsigned long)(r.seconds > 0 ?
+                                         r.events / r.seconds : 0)
+                      << std::setw(14) << r.rss
+                      << (r.failed ? "  failed" : "") << std::endl;
+        }
+    }
+
+    std::ofstream file(output.c_str());
+
+    json(file, results);
+    if (not file) {
+        std::cerr << "cannot write " << output << std::endl;
+        return 1;
+    }
+    return 0;
+}
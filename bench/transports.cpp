@@ -0,0 +1,158 @@
+/**
+ * @file transports.cpp
+ * @author The VLE Development Team
+ * See the AUTHORS or Authors.txt file
+ */
+
+/*
+ * Copyright (C) 2012 ULCO http://www.univ-littoral.fr
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Departure of docked transports: every transport is looked up by its
+ * identifier (Transit::output) then removed (Transit::removeReadyTransports)
+ * in an order that differs from the arrival order. The linear walk over a
+ * std::list used before the hashed index is measured against
+ * OrderedTransportList.
+ */
+
+#include <Transport.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <algorithm>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+
+using namespace logistics;
+
+namespace {
+
+typedef std::list < Transport* > TransportList;
+
+Transport* scanFind(const TransportList& transports, TransportID id)
+{
+    for (TransportList::const_iterator it = transports.begin();
+         it != transports.end(); ++it) {
+        if ((*it)->id() == id) {
+            return *it;
+        }
+    }
+    return 0;
+}
+
+void scanErase(TransportList& transports, TransportID id)
+{
+    for (TransportList::iterator it = transports.begin();
+         it != transports.end(); ++it) {
+        if ((*it)->id() == id) {
+            transports.erase(it);
+            return;
+        }
+    }
+}
+
+double elapsed(const boost::posix_time::ptime& start)
+{
+    return (boost::posix_time::microsec_clock::universal_time() - start)
+        .total_microseconds() / 1000.;
+}
+
+double scan(const Transports& transports,
+            const std::vector < TransportID >& departures)
+{
+    TransportList list(transports.begin(), transports.end());
+    boost::posix_time::ptime start =
+        boost::posix_time::microsec_clock::universal_time();
+    unsigned int found = 0;
+
+    for (std::vector < TransportID >::const_iterator it = departures.begin();
+         it != departures.end(); ++it) {
+        found += scanFind(list, *it) != 0;
+        scanErase(list, *it);
+    }
+    if (found != departures.size() or not list.empty()) {
+        std::cerr << "scan: inconsistent result" << std::endl;
+    }
+    return elapsed(start);
+}
+
+double indexed(const Transports& transports,
+               const std::vector < TransportID >& departures)
+{
+    OrderedTransportList list;
+
+    for (Transports::const_iterator it = transports.begin();
+         it != transports.end(); ++it) {
+        list.push_back(*it);
+    }
+
+    boost::posix_time::ptime start =
+        boost::posix_time::microsec_clock::universal_time();
+    unsigned int found = 0;
+
+    for (std::vector < TransportID >::const_iterator it = departures.begin();
+         it != departures.end(); ++it) {
+        found += list.find(*it) != 0;
+        list.erase(*it);
+    }
+    if (found != departures.size() or not list.empty()) {
+        std::cerr << "indexed: inconsistent result" << std::endl;
+    }
+    return elapsed(start);
+}
+
+} // anonymous namespace
+
+int main(int argc, char* argv[])
+{
+    std::vector < unsigned int > sizes;
+
+    for (int i = 1; i < argc; ++i) {
+        sizes.push_back(std::atoi(argv[i]));
+    }
+    if (sizes.empty()) {
+        sizes.push_back(1000);
+        sizes.push_back(5000);
+        sizes.push_back(20000);
+    }
+
+    std::srand(545404204);
+    std::cout << std::setw(12) << "transports" << std::setw(14) << "scan (ms)"
+              << std::setw(14) << "indexed (ms)" << std::setw(10) << "gain"
+              << std::endl;
+
+    for (std::vector < unsigned int >::const_iterator it = sizes.begin();
+         it != sizes.end(); ++it) {
+        Transports transports;
+        std::vector < TransportID > departures;
+        LocationID destination = Locations::id("Platform2");
+
+        for (unsigned int i = 0; i < *it; ++i) {
+            transports.push_back(new Transport(i, TRUCK, 10, destination,
+                                               FOOD, 10.));
+            departures.push_back(i);
+        }
+        std::random_shuffle(departures.begin(), departures.end());
+
+        double s = scan(transports, departures);
+        double i = indexed(transports, departures);
+
+        std::cout << std::setw(12) << *it << std::setw(14) << s
+                  << std::setw(14) << i << std::setw(10)
+                  << (i > 0 ? s / i : 0) << std::endl;
+    }
+    return 0;
+}
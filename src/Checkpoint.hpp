@@ -0,0 +1,430 @@
+/**
+ * @file Checkpoint.hpp
+ * @author The VLE Development Team
+ * See the AUTHORS or Authors.txt file
+ */
+
+/*
+ * Copyright (C) 2012 ULCO http://www.univ-littoral.fr
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CHECKPOINT_HPP
+#define CHECKPOINT_HPP 1
+
+#include <vle/devs/Time.hpp>
+#include <vle/graph/Model.hpp>
+#include <vle/utils/Exception.hpp>
+#include <Location.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/static_assert.hpp>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace logistics {
+
+/*
+ * Binary checkpoint of a simulation, in the byte order of the machine
+ * that wrote it:
+ *
+ *   CheckpointHeader
+ *   for each model, by name:
+ *     the length of its name (uint32), its name, the length of its
+ *     record (uint64), its record
+ *   the location names, NUL-terminated, at offset CheckpointHeader::names
+ *
+ * A model is named by the path of its coupled models, the root excluded
+ * (see Checkpoint::key). Each dynamics writes and reads its own record
+ * with CheckpointWriter and CheckpointReader; locations are stored as
+ * indexes in the name table, as in the traces (see Trace.hpp).
+ */
+
+struct CheckpointHeader
+{
+    char magic[8];
+    boost::uint32_t version;
+    boost::uint32_t locations;
+    boost::uint64_t models;
+    boost::uint64_t names;
+    boost::uint32_t containerID;
+    boost::uint32_t transportID;
+    double date;
+};
+
+BOOST_STATIC_ASSERT(sizeof(CheckpointHeader) == 48);
+
+static const char CHECKPOINT_MAGIC[8] =
+    { 'L', 'O', 'G', 'C', 'H', 'K', 'P', 'T' };
+static const boost::uint32_t CHECKPOINT_VERSION = 2;
+
+/**
+ * The records of the models of one simulation, with the identifier
+ * sequences of the simulation and the date it was taken at. A
+ * checkpoint is either filled by the models and saved, or read from a
+ * file and handed out to the models.
+ */
+class Checkpoint : private boost::noncopyable
+{
+public:
+    Checkpoint() :
+        mContainerID(0), mTransportID(0), mDate(0)
+    { }
+
+    Checkpoint(const std::string& path) :
+        mPath(path), mContainerID(0), mTransportID(0), mDate(0)
+    {
+        std::ifstream file(path.c_str(), std::ios::in | std::ios::binary);
+        std::string data;
+        CheckpointHeader header;
+
+        if (not file) {
+            error("cannot open");
+        }
+        data.assign(std::istreambuf_iterator < char >(file),
+                    std::istreambuf_iterator < char >());
+        if (data.size() < sizeof(CheckpointHeader)) {
+            error("truncated header");
+        }
+        std::memcpy(&header, data.data(), sizeof(CheckpointHeader));
+        if (std::memcmp(header.magic, CHECKPOINT_MAGIC,
+                        sizeof(CHECKPOINT_MAGIC)) or
+            header.version != CHECKPOINT_VERSION) {
+            error("not a version 2 checkpoint");
+        }
+        if (header.names < sizeof(CheckpointHeader) or
+            header.names > data.size()) {
+            error("bad name table offset");
+        }
+        mContainerID = header.containerID;
+        mTransportID = header.transportID;
+        mDate = header.date;
+
+        std::size_t cursor = header.names;
+
+        for (boost::uint32_t i = 0; i < header.locations; ++i) {
+            std::size_t last = data.find('\0', cursor);
+
+            if (last == std::string::npos) {
+                error("truncated name table");
+            }
+            mLocations.push_back(
+                Locations::id(data.substr(cursor, last - cursor)));
+            cursor = last + 1;
+        }
+
+        cursor = sizeof(CheckpointHeader);
+        for (boost::uint64_t i = 0; i < header.models; ++i) {
+            boost::uint32_t name;
+            boost::uint64_t size;
+
+            extract(data, header.names, cursor, &name, sizeof(name));
+
+            std::string model(name, '\0');
+
+            extract(data, header.names, cursor, &model[0], name);
+            extract(data, header.names, cursor, &size, sizeof(size));
+            if (size > header.names - cursor) {
+                error("truncated record of " + model);
+            }
+            mRecords[model].assign(data, cursor, size);
+            cursor += size;
+        }
+    }
+
+    /**
+     * Name of model in the checkpoints: the names of its coupled models
+     * but the root, then its own, separated by colons.
+     */
+    static std::string key(const vle::graph::Model& model)
+    {
+        std::string key = model.getName();
+
+        for (const vle::graph::Model* parent = model.getParent();
+             parent and parent->getParent(); parent = parent->getParent()) {
+            key = parent->getName() + ":" + key;
+        }
+        return key;
+    }
+
+    const std::string& path() const
+    { return mPath; }
+
+    /**
+     * Record of model, to be filled.
+     */
+    std::string& record(const std::string& model)
+    { return mRecords[model]; }
+
+    /**
+     * Record of model, or null if the checkpoint has none.
+     */
+    const std::string* record(const std::string& model) const
+    {
+        Records::const_iterator it = mRecords.find(model);
+
+        return it == mRecords.end() ? 0 : &it->second;
+    }
+
+    boost::uint32_t containerID() const
+    { return mContainerID; }
+
+    boost::uint32_t transportID() const
+    { return mTransportID; }
+
+    void sequences(boost::uint32_t containerID, boost::uint32_t transportID)
+    {
+        mContainerID = containerID;
+        mTransportID = transportID;
+    }
+
+    double date() const
+    { return mDate; }
+
+    void date(double date)
+    { mDate = date; }
+
+    /**
+     * Index of location in the name table written by save().
+     */
+    boost::uint32_t index(LocationID location)
+    {
+        std::map < LocationID, boost::uint32_t >::const_iterator it =
+            mIndex.find(location);
+
+        if (it != mIndex.end()) {
+            return it->second;
+        }
+        mNames.push_back(Locations::name(location));
+        return mIndex[location] = mNames.size() - 1;
+    }
+
+    /**
+     * Location of index in the name table read from the file.
+     */
+    LocationID location(boost::uint32_t index) const
+    {
+        if (index >= mLocations.size()) {
+            error("bad location index");
+        }
+        return mLocations[index];
+    }
+
+    void save(const std::string& path)
+    {
+        std::ofstream file(path.c_str(), std::ios::out | std::ios::binary |
+                           std::ios::trunc);
+        CheckpointHeader header;
+
+        mPath = path;
+        if (not file) {
+            error("cannot write");
+        }
+        std::memset(&header, 0, sizeof(CheckpointHeader));
+        std::memcpy(header.magic, CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC));
+        header.version = CHECKPOINT_VERSION;
+        header.locations = mNames.size();
+        header.models = mRecords.size();
+        header.containerID = mContainerID;
+        header.transportID = mTransportID;
+        header.date = mDate;
+        header.names = sizeof(CheckpointHeader);
+        for (Records::const_iterator it = mRecords.begin();
+             it != mRecords.end(); ++it) {
+            header.names += sizeof(boost::uint32_t) + it->first.size() +
+                sizeof(boost::uint64_t) + it->second.size();
+        }
+        write(file, &header, sizeof(CheckpointHeader));
+        for (Records::const_iterator it = mRecords.begin();
+             it != mRecords.end(); ++it) {
+            boost::uint32_t name = it->first.size();
+            boost::uint64_t size = it->second.size();
+
+            write(file, &name, sizeof(name));
+            write(file, it->first.data(), name);
+            write(file, &size, sizeof(size));
+            write(file, it->second.data(), size);
+        }
+        for (std::vector < std::string >::const_iterator it =
+                 mNames.begin(); it != mNames.end(); ++it) {
+            write(file, it->c_str(), it->size() + 1);
+        }
+    }
+
+    void error(const std::string& message) const
+    {
+        throw vle::utils::ModellingError(
+            "checkpoint " + mPath + ": " + message);
+    }
+
+private:
+    typedef std::map < std::string, std::string > Records;
+
+    void extract(const std::string& data, std::size_t end,
+                 std::size_t& cursor, void* value, std::size_t size) const
+    {
+        if (size > end - cursor) {
+            error("truncated model table");
+        }
+        std::memcpy(value, data.data() + cursor, size);
+        cursor += size;
+    }
+
+    void write(std::ofstream& file, const void* data, std::size_t size)
+    {
+        if (not file.write(static_cast < const char* >(data), size)) {
+            error("write error");
+        }
+    }
+
+    std::string mPath;
+    Records mRecords;
+    boost::uint32_t mContainerID;
+    boost::uint32_t mTransportID;
+    double mDate;
+
+    // writing
+    std::vector < std::string > mNames;
+    std::map < LocationID, boost::uint32_t > mIndex;
+
+    // reading
+    std::vector < LocationID > mLocations;
+};
+
+/**
+ * Appends the state of one model to its record. Numbers are written as
+ * they are in memory: only give write() arithmetic values.
+ */
+class CheckpointWriter
+{
+public:
+    CheckpointWriter(Checkpoint& checkpoint, const vle::graph::Model& model) :
+        mCheckpoint(checkpoint),
+        mRecord(checkpoint.record(Checkpoint::key(model)))
+    { mRecord.clear(); }
+
+    template < typename T >
+    void write(T value)
+    { mRecord.append(reinterpret_cast < const char* >(&value), sizeof(T)); }
+
+    void write(bool value)
+    { write((boost::uint8_t)value); }
+
+    void write(const vle::devs::Time& time)
+    { write(time.getValue()); }
+
+    void write(const std::string& value)
+    {
+        write((boost::uint32_t)value.size());
+        mRecord.append(value);
+    }
+
+    void location(LocationID location)
+    { write(mCheckpoint.index(location)); }
+
+private:
+    Checkpoint& mCheckpoint;
+    std::string& mRecord;
+};
+
+/**
+ * Reads back the record of one model, in the order it was written.
+ */
+class CheckpointReader
+{
+public:
+    CheckpointReader(const Checkpoint& checkpoint,
+                     const vle::graph::Model& model) :
+        mCheckpoint(checkpoint), mModel(Checkpoint::key(model)),
+        mRecord(checkpoint.record(mModel)), mCursor(0)
+    {
+        if (not mRecord) {
+            checkpoint.error("no record of " + mModel);
+        }
+    }
+
+    template < typename T >
+    void read(T& value)
+    {
+        if (sizeof(T) > mRecord->size() - mCursor) {
+            mCheckpoint.error("truncated record of " + mModel);
+        }
+        std::memcpy(&value, mRecord->data() + mCursor, sizeof(T));
+        mCursor += sizeof(T);
+    }
+
+    void read(bool& value)
+    {
+        boost::uint8_t byte;
+
+        read(byte);
+        value = byte;
+    }
+
+    void read(vle::devs::Time& time)
+    {
+        double value;
+
+        read(value);
+        time = value;
+    }
+
+    void read(std::string& value)
+    {
+        boost::uint32_t size;
+
+        read(size);
+        if (size > mRecord->size() - mCursor) {
+            mCheckpoint.error("truncated record of " + mModel);
+        }
+        value.assign(*mRecord, mCursor, size);
+        mCursor += size;
+    }
+
+    /**
+     * The next value of type T.
+     */
+    template < typename T >
+    T get()
+    {
+        T value;
+
+        read(value);
+        return value;
+    }
+
+    LocationID location()
+    { return mCheckpoint.location(get < boost::uint32_t >()); }
+
+    /**
+     * Raise an error about the record.
+     */
+    void error(const std::string& message) const
+    { mCheckpoint.error(mModel + ": " + message); }
+
+private:
+    const Checkpoint& mCheckpoint;
+    std::string mModel;
+    const std::string* mRecord;
+    std::size_t mCursor;
+};
+
+} // namespace logistics
+
+#endif
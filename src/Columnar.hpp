@@ -0,0 +1,428 @@
+/**
+ * @file Columnar.hpp
+ * @author The VLE Development Team
+ * See the AUTHORS or Authors.txt file
+ */
+
+/*
+ * Copyright (C) 2012 ULCO http://www.univ-littoral.fr
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef COLUMNAR_HPP
+#define COLUMNAR_HPP 1
+
+#include <vle/utils/Exception.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/iostreams/copy.hpp>
+#include <boost/iostreams/device/array.hpp>
+#include <boost/iostreams/device/back_inserter.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
+#include <boost/iostreams/filter/zlib.hpp>
+#include <boost/iostreams/filtering_stream.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/static_assert.hpp>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace logistics {
+
+/*
+ * Columnar file of observations, in the byte order of the machine that
+ * wrote it:
+ *
+ *   ColumnarHeader
+ *   blocks, in the order they were written:
+ *     a COLUMN block, followed by the name of a new column
+ *     a CHUNK block, followed by up to COLUMNAR_CHUNK_SIZE (date,
+ *     value) pairs of one column, compressed
+ *
+ * A chunk holds the dates, then the values. Each number is XORed with
+ * the previous one of its array, so that repeated values and regular
+ * dates become runs of zero bytes. The bytes are then transposed, byte
+ * 0 of every number first, and the whole chunk is deflated. Chunks
+ * decode on their own. The file is only appended to, and flushed after
+ * each chunk: a run that stops early leaves a readable file with the
+ * chunks written so far.
+ */
+
+struct ColumnarHeader
+{
+    char magic[8];
+    boost::uint32_t version;
+    boost::uint32_t reserved;
+};
+
+struct ColumnarBlock
+{
+    boost::uint32_t kind;
+    boost::uint32_t column;
+    boost::uint32_t count;
+    boost::uint32_t size;
+};
+
+BOOST_STATIC_ASSERT(sizeof(ColumnarHeader) == 16);
+BOOST_STATIC_ASSERT(sizeof(ColumnarBlock) == 16);
+
+static const char COLUMNAR_MAGIC[8] = { 'L', 'O', 'G', 'C', 'O', 'L', 'S',
+                                        '\0' };
+static const boost::uint32_t COLUMNAR_VERSION = 1;
+static const boost::uint32_t COLUMNAR_CHUNK_SIZE = 4096;
+
+enum ColumnarBlockKind { COLUMNAR_COLUMN_BLOCK = 1,
+                         COLUMNAR_CHUNK_BLOCK = 2 };
+
+namespace columnar {
+
+/**
+ * Append the n numbers, XORed with their predecessor and transposed, to
+ * bytes.
+ */
+inline void encode(const double* numbers, std::size_t n, std::string& bytes)
+{
+    std::size_t start = bytes.size();
+    boost::uint64_t previous = 0;
+
+    bytes.resize(start + n * sizeof(double));
+    for (std::size_t i = 0; i < n; ++i) {
+        boost::uint64_t bits;
+
+        std::memcpy(&bits, numbers + i, sizeof(bits));
+        for (std::size_t b = 0; b < sizeof(bits); ++b) {
+            bytes[start + b * n + i] = (char)((bits ^ previous) >> (8 * b));
+        }
+        previous = bits;
+    }
+}
+
+/**
+ * The n numbers encoded from bytes.
+ */
+inline void decode(const char* bytes, std::size_t n, double* numbers)
+{
+    boost::uint64_t previous = 0;
+
+    for (std::size_t i = 0; i < n; ++i) {
+        boost::uint64_t bits = 0;
+
+        for (std::size_t b = 0; b < sizeof(bits); ++b) {
+            bits |= (boost::uint64_t)(unsigned char)bytes[b * n + i] <<
+                (8 * b);
+        }
+        bits ^= previous;
+        std::memcpy(numbers + i, &bits, sizeof(bits));
+        previous = bits;
+    }
+}
+
+} // namespace columnar
+
+/**
+ * Writer of a columnar file. Each column buffers its last pairs and
+ * appends them as one chunk when COLUMNAR_CHUNK_SIZE of them are
+ * waiting; close() appends the partial chunks.
+ */
+class ColumnarWriter : private boost::noncopyable
+{
+public:
+    ColumnarWriter(const std::string& path) :
+        mPath(path), mFile(path.c_str(), std::ios::out | std::ios::binary |
+                           std::ios::trunc)
+    {
+        ColumnarHeader header;
+
+        if (not mFile) {
+            throw vle::utils::FileError("columnar " + path +
+                                        ": cannot write");
+        }
+        std::memset(&header, 0, sizeof(ColumnarHeader));
+        std::memcpy(header.magic, COLUMNAR_MAGIC, sizeof(COLUMNAR_MAGIC));
+        header.version = COLUMNAR_VERSION;
+        write(&header, sizeof(ColumnarHeader));
+    }
+
+    ~ColumnarWriter()
+    {
+        try {
+            close();
+        } catch (const std::exception& /* e */) {
+        }
+    }
+
+    /**
+     * Index of the column name, which is declared on first use.
+     */
+    boost::uint32_t column(const std::string& name)
+    {
+        std::map < std::string, boost::uint32_t >::const_iterator it =
+            mIndex.find(name);
+
+        if (it != mIndex.end()) {
+            return it->second;
+        }
+
+        ColumnarBlock block = { COLUMNAR_COLUMN_BLOCK,
+                                (boost::uint32_t)mColumns.size(), 0,
+                                (boost::uint32_t)name.size() };
+
+        write(&block, sizeof(ColumnarBlock));
+        write(name.data(), name.size());
+        mColumns.push_back(Column());
+        return mIndex[name] = block.column;
+    }
+
+    void add(boost::uint32_t column, double date, double value)
+    {
+        Column& series = mColumns[column];
+
+        series.dates.push_back(date);
+        series.values.push_back(value);
+        if (series.dates.size() == COLUMNAR_CHUNK_SIZE) {
+            flush(column);
+        }
+    }
+
+    void close()
+    {
+        if (mFile.is_open()) {
+            for (boost::uint32_t i = 0; i < mColumns.size(); ++i) {
+                flush(i);
+            }
+            mFile.close();
+        }
+    }
+
+private:
+    struct Column
+    {
+        std::vector < double > dates;
+        std::vector < double > values;
+    };
+
+    void flush(boost::uint32_t column)
+    {
+        Column& series = mColumns[column];
+
+        if (series.dates.empty()) {
+            return;
+        }
+        mRaw.clear();
+        columnar::encode(&series.dates[0], series.dates.size(), mRaw);
+        columnar::encode(&series.values[0], series.values.size(), mRaw);
+        mCompressed.clear();
+        {
+            boost::iostreams::filtering_ostream out;
+
+            out.push(boost::iostreams::zlib_compressor(
+                         boost::iostreams::zlib::best_speed));
+            out.push(boost::iostreams::back_inserter(mCompressed));
+            out.write(mRaw.data(), mRaw.size());
+        }
+
+        ColumnarBlock block = { COLUMNAR_CHUNK_BLOCK, column,
+                                (boost::uint32_t)series.dates.size(),
+                                (boost::uint32_t)mCompressed.size() };
+
+        write(&block, sizeof(ColumnarBlock));
+        write(mCompressed.data(), mCompressed.size());
+        // the chunk, and the blocks before it, reach the file now
+        if (not mFile.flush()) {
+            throw vle::utils::FileError("columnar " + mPath +
+                                        ": write error");
+        }
+        series.dates.clear();
+        series.values.clear();
+    }
+
+    void write(const void* data, std::size_t size)
+    {
+        if (not mFile.write(static_cast < const char* >(data), size)) {
+            throw vle::utils::FileError("columnar " + mPath +
+                                        ": write error");
+        }
+    }
+
+    std::string mPath;
+    std::ofstream mFile;
+    std::vector < Column > mColumns;
+    std::map < std::string, boost::uint32_t > mIndex;
+
+    // reused by the chunks
+    std::string mRaw;
+    std::string mCompressed;
+};
+
+/**
+ * Reader of a columnar file, memory mapped. Opening the file only walks
+ * the block headers; the chunks of a column are inflated when the
+ * column is read, all at once with series() or one at a time with
+ * chunk(). A last block cut short, by a run that stopped while writing
+ * it, is ignored.
+ */
+class ColumnarReader : private boost::noncopyable
+{
+public:
+    ColumnarReader(const std::string& path) :
+        mPath(path)
+    {
+        try {
+            mFile.open(path);
+        } catch (const std::exception& e) {
+            throw vle::utils::FileError("columnar " + path + ": " +
+                                        e.what());
+        }
+        if (mFile.size() < sizeof(ColumnarHeader) or
+            std::memcmp(mFile.data(), COLUMNAR_MAGIC,
+                        sizeof(COLUMNAR_MAGIC)) or
+            reinterpret_cast < const ColumnarHeader* >(
+                mFile.data())->version != COLUMNAR_VERSION) {
+            error("not a version 1 columnar file");
+        }
+
+        std::size_t cursor = sizeof(ColumnarHeader);
+
+        while (mFile.size() - cursor >= sizeof(ColumnarBlock)) {
+            ColumnarBlock block;
+
+            std::memcpy(&block, mFile.data() + cursor, sizeof(block));
+            if (block.size > mFile.size() - cursor - sizeof(block)) {
+                break;
+            }
+            cursor += sizeof(block);
+            if (block.kind == COLUMNAR_COLUMN_BLOCK) {
+                if (block.column != mColumns.size()) {
+                    error("bad column declaration");
+                }
+                mColumns.push_back(
+                    std::string(mFile.data() + cursor, block.size));
+                mChunks.push_back(std::vector < Chunk >());
+            } else if (block.kind == COLUMNAR_CHUNK_BLOCK and
+                       block.column < mColumns.size()) {
+                Chunk chunk = { cursor, block.count, block.size };
+
+                mChunks[block.column].push_back(chunk);
+            } else {
+                error("bad block");
+            }
+            cursor += block.size;
+        }
+    }
+
+    /**
+     * Names of the columns, by index.
+     */
+    const std::vector < std::string >& columns() const
+    { return mColumns; }
+
+    /**
+     * Index of the column name, or columns().size() if there is none.
+     */
+    std::size_t find(const std::string& name) const
+    {
+        std::size_t i = 0;
+
+        while (i < mColumns.size() and mColumns[i] != name) {
+            ++i;
+        }
+        return i;
+    }
+
+    std::size_t chunks(std::size_t column) const
+    { return mChunks.at(column).size(); }
+
+    /**
+     * Number of pairs of column, without inflating its chunks.
+     */
+    std::size_t size(std::size_t column) const
+    {
+        std::size_t size = 0;
+
+        for (std::size_t i = 0; i < chunks(column); ++i) {
+            size += mChunks[column][i].count;
+        }
+        return size;
+    }
+
+    /**
+     * Append the pairs of chunk i of column to dates and values.
+     */
+    void chunk(std::size_t column, std::size_t i,
+               std::vector < double >& dates,
+               std::vector < double >& values) const
+    {
+        const Chunk& chunk = mChunks.at(column).at(i);
+        std::string raw;
+
+        try {
+            boost::iostreams::filtering_istream in;
+
+            in.push(boost::iostreams::zlib_decompressor());
+            in.push(boost::iostreams::array_source(
+                        mFile.data() + chunk.offset, chunk.size));
+            boost::iostreams::copy(in, boost::iostreams::back_inserter(raw));
+        } catch (const std::exception& e) {
+            error(mColumns[column] + ": " + e.what());
+        }
+        if (raw.size() != 2 * chunk.count * sizeof(double)) {
+            error(mColumns[column] + ": bad chunk size");
+        }
+
+        std::size_t start = dates.size();
+
+        dates.resize(start + chunk.count);
+        values.resize(start + chunk.count);
+        if (chunk.count) {
+            columnar::decode(raw.data(), chunk.count, &dates[start]);
+            columnar::decode(raw.data() + chunk.count * sizeof(double),
+                             chunk.count, &values[start]);
+        }
+    }
+
+    /**
+     * Append every pair of column to dates and values.
+     */
+    void series(std::size_t column, std::vector < double >& dates,
+                std::vector < double >& values) const
+    {
+        for (std::size_t i = 0; i < chunks(column); ++i) {
+            chunk(column, i, dates, values);
+        }
+    }
+
+private:
+    struct Chunk
+    {
+        std::size_t offset;
+        boost::uint32_t count;
+        boost::uint32_t size;
+    };
+
+    void error(const std::string& message) const
+    {
+        throw vle::utils::FileError("columnar " + mPath + ": " + message);
+    }
+
+    std::string mPath;
+    boost::iostreams::mapped_file_source mFile;
+    std::vector < std::string > mColumns;
+    std::vector < std::vector < Chunk > > mChunks;
+};
+
+} // namespace logistics
+
+#endif
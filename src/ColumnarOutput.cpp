@@ -0,0 +1,134 @@
+/**
+ * @file ColumnarOutput.cpp
+ * @author The VLE Development Team
+ * See the AUTHORS or Authors.txt file
+ */
+
+/*
+ * Copyright (C) 2012 ULCO http://www.univ-littoral.fr
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <vle/oov/Plugin.hpp>
+#include <vle/value/Value.hpp>
+#include <Columnar.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <limits>
+
+namespace logistics {
+
+/**
+ * Output plugin writing each view to location/file.col (see
+ * Columnar.hpp), one column per observed "parent:model.port", as the
+ * columns of the text views. Integers, reals and booleans are stored as
+ * reals; a missing or other value, as NaN.
+ */
+class ColumnarOutput : public vle::oov::Plugin
+{
+public:
+    ColumnarOutput(const std::string& location) :
+        vle::oov::Plugin(location)
+    { }
+
+    virtual ~ColumnarOutput()
+    { }
+
+    virtual void onParameter(const std::string& /* plugin */,
+                             const std::string& location,
+                             const std::string& file,
+                             vle::value::Value* parameters,
+                             const double& /* time */)
+    {
+        delete parameters;
+        mWriter.reset(new ColumnarWriter(
+                          (location.empty() ? std::string(".") : location) +
+                          "/" + file + ".col"));
+    }
+
+    virtual void onNewObservable(const std::string& simulator,
+                                 const std::string& parent,
+                                 const std::string& port,
+                                 const std::string& /* view */,
+                                 const double& /* time */)
+    {
+        column(simulator, parent, port);
+    }
+
+    virtual void onDelObservable(const std::string& /* simulator */,
+                                 const std::string& /* parent */,
+                                 const std::string& /* port */,
+                                 const std::string& /* view */,
+                                 const double& /* time */)
+    { }
+
+    virtual void onValue(const std::string& simulator,
+                         const std::string& parent,
+                         const std::string& port,
+                         const std::string& /* view */,
+                         const double& time,
+                         vle::value::Value* value)
+    {
+        double number = std::numeric_limits < double >::quiet_NaN();
+
+        if (value) {
+            switch (value->getType()) {
+            case vle::value::Value::BOOLEAN:
+                number = vle::value::toBoolean(value);
+                break;
+            case vle::value::Value::INTEGER:
+                number = vle::value::toInteger(value);
+                break;
+            case vle::value::Value::DOUBLE:
+                number = vle::value::toDouble(value);
+                break;
+            default:
+                break;
+            }
+            delete value;
+        }
+        if (not simulator.empty()) {
+            mWriter->add(column(simulator, parent, port), time, number);
+        }
+    }
+
+    virtual void close(const double& /* time */)
+    {
+        mWriter->close();
+    }
+
+private:
+    boost::uint32_t column(const std::string& simulator,
+                           const std::string& parent,
+                           const std::string& port)
+    {
+        mName.assign(parent);
+        if (not parent.empty()) {
+            mName.push_back(':');
+        }
+        mName.append(simulator);
+        mName.push_back('.');
+        mName.append(port);
+        return mWriter->column(mName);
+    }
+
+    boost::scoped_ptr < ColumnarWriter > mWriter;
+
+    // reused by each value
+    std::string mName;
+};
+
+} // namespace logistics
+
+DECLARE_OOV_PLUGIN(logistics::ColumnarOutput);
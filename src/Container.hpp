@@ -26,6 +26,14 @@
 
 #include <vle/value/Map.hpp>
 #include <vle/devs/Time.hpp>
+#include <Checkpoint.hpp>
+#include <ExactSum.hpp>
+#include <Location.hpp>
+#include <Pool.hpp>
+#include <boost/shared_ptr.hpp>
+#include <algorithm>
+#include <map>
+#include <vector>
 
 using namespace vle::devs;
 using namespace vle::value;
@@ -36,24 +44,27 @@ enum ContentType { FOOD, NOFOOD };
 
 typedef unsigned int ContainerID;
 
-typedef std::vector < std::string > path_t;
+typedef std::vector < LocationID > path_t;
 
-class Container
+typedef std::size_t ContainerSlot;
+
+class Container : public Pooled
 {
 public:
-    Container(ContainerID id, const std::string& source,
-              const std::string& destination, ContentType contentType,
+    Container(ContainerID id, LocationID source,
+              LocationID destination, ContentType contentType,
               Time exigibilityDate) :
         mID(id), mSource(source),
         mDestination(destination), mContentType(contentType),
-        mExigibilityDate(exigibilityDate)
+        mExigibilityDate(exigibilityDate), mWaiting(false)
     { }
 
-    Container(const Map& value)
+    Container(const Map& value) : mWaiting(false)
     {
         mID = (ContainerID)toInteger(value.get("Id"));
-        mSource = vle::value::toString(value.get("Source"));
-        mDestination = vle::value::toString(value.get("Destination"));
+        mSource = Locations::id(vle::value::toString(value.get("Source")));
+        mDestination =
+            Locations::id(vle::value::toString(value.get("Destination")));
         mContentType =
             (ContentType)toInteger(value.get("ContentType"));
         mExigibilityDate = (Time)toDouble(value.get("ExigibilityDate"));
@@ -61,11 +72,26 @@ public:
             const Set* path = toSetValue(value.get("Path"));
 
             for (unsigned int i = 0; i < path->size(); ++i) {
-                mPath.push_back(vle::value::toString(path->get(i)));
+                mPath.push_back(
+                    Locations::id(vle::value::toString(path->get(i))));
             }
         }
     }
 
+    Container(CheckpointReader& in) : mWaiting(false)
+    {
+        mID = in.get < boost::uint32_t >();
+        mSource = in.location();
+        mDestination = in.location();
+        mContentType = (ContentType)in.get < boost::uint8_t >();
+        in.read(mExigibilityDate);
+        in.read(mArrivalDate);
+        mPath.resize(in.get < boost::uint32_t >());
+        for (path_t::iterator it = mPath.begin(); it != mPath.end(); ++it) {
+            *it = in.location();
+        }
+    }
+
     virtual ~Container()
     { }
 
@@ -75,7 +101,7 @@ public:
     Time arrivalDate() const
     { return mArrivalDate; }
 
-    std::string destination() const
+    LocationID destination() const
     { return mDestination; }
 
     Time exigibilityDate() const
@@ -84,17 +110,33 @@ public:
     ContainerID id() const
     { return mID; }
 
+    void leave()
+    { mWaiting = false; }
+
+    ContainerSlot slot() const
+    { return mSlot; }
+
+    void wait(ContainerSlot slot)
+    {
+        mSlot = slot;
+        mWaiting = true;
+    }
+
+    bool waiting() const
+    { return mWaiting; }
+
     std::string toString() const
     {
         std::ostringstream str;
 
-        str << "Container[ " << mID << " " << " " << mSource
-            << " " << mDestination
+        str << "Container[ " << mID << " " << " "
+            << Locations::name(mSource)
+            << " " << Locations::name(mDestination)
             << " " << ((mContentType == FOOD) ? "FOOD" : "NOFOOD")
             << " " << mExigibilityDate << " < ";
         for (path_t::const_iterator it = mPath.begin();
              it != mPath.end(); ++it) {
-            str << *it;
+            str << Locations::name(*it);
         }
         str << "> ] ";
         return str.str();
@@ -105,8 +147,9 @@ public:
         Map* value = new Map;
 
         value->addInt("Id", (int)mID);
-        value->addString("Source", mSource);
-        value->addString("Destination", mDestination);
+        value->addString("Source", Locations::name(mSource));
+        value->addString("Destination",
+                         Locations::name(mDestination));
         value->addInt("ContentType", mContentType);
         value->addDouble("ExigibilityDate", mExigibilityDate.getValue());
         {
@@ -114,24 +157,41 @@ public:
 
             for (path_t::const_iterator it = mPath.begin();
                  it != mPath.end(); ++it) {
-                path->addString(*it);
+                path->addString(Locations::name(*it));
             }
             value->add("Path", path);
         }
         return value;
     }
 
+    void save(CheckpointWriter& out) const
+    {
+        out.write((boost::uint32_t)mID);
+        out.location(mSource);
+        out.location(mDestination);
+        out.write((boost::uint8_t)mContentType);
+        out.write(mExigibilityDate);
+        out.write(mArrivalDate);
+        out.write((boost::uint32_t)mPath.size());
+        for (path_t::const_iterator it = mPath.begin(); it != mPath.end();
+             ++it) {
+            out.location(*it);
+        }
+    }
+
     ContentType type() const
     { return mContentType; }
 
 private:
     ContainerID mID;
-    std::string mSource;
-    std::string mDestination;
+    LocationID mSource;
+    LocationID mDestination;
     ContentType mContentType;
     Time mExigibilityDate;
     Time mArrivalDate;
     path_t mPath;
+    ContainerSlot mSlot;
+    bool mWaiting;
 };
 
 class Containers : public std::vector < Container* >
@@ -196,6 +256,215 @@ public:
     }
 };
 
+typedef boost::shared_ptr < const Container > ContainerHandle;
+
+/**
+ * Containers shared, read-only, between the models and the events that
+ * carry them; see Payload.hpp.
+ */
+class SharedContainers : public std::vector < ContainerHandle >
+{
+public:
+    SharedContainers()
+    { }
+
+    SharedContainers(const Set& value, ObjectPool& pool)
+    {
+        for (unsigned int i = 0; i < value.size(); ++i) {
+            push_back(ContainerHandle(
+                          new (pool) Container(*toMapValue(value.get(i)))));
+        }
+    }
+
+    SharedContainers(CheckpointReader& in, ObjectPool& pool)
+    {
+        resize(in.get < boost::uint32_t >());
+        for (iterator it = begin(); it != end(); ++it) {
+            it->reset(new (pool) Container(in));
+        }
+    }
+
+    void save(CheckpointWriter& out) const
+    {
+        out.write((boost::uint32_t)size());
+        for (const_iterator it = begin(); it != end(); ++it) {
+            (*it)->save(out);
+        }
+    }
+
+    std::string toString() const
+    {
+        std::string str = "{ ";
+
+        for (const_iterator it = begin(); it != end(); ++it) {
+            str += (*it)->toString();
+        }
+        str += "}";
+        return str;
+    }
+
+    Value* toValue() const
+    {
+        Set* value = new Set;
+
+        for (const_iterator it = begin(); it != end(); ++it) {
+            value->add((*it)->toValue());
+        }
+        return value;
+    }
+};
+
+/**
+ * Containers waiting in a transit zone. Rows are not kept in arrival
+ * order, as remove() moves the last row into the hole it leaves; each
+ * row has an arrival rank instead. An index ordered by exigibility date
+ * then rank gives pop() the first container that arrived among those
+ * with the earliest exigibility date in logarithmic time. Each waiting
+ * container keeps its row, so remove() does not search for it. The
+ * observation aggregate is kept as the containers come and go (see
+ * timeInTransit()).
+ */
+class WaitingContainers
+{
+public:
+    WaitingContainers() : mRank(0)
+    { }
+
+    virtual ~WaitingContainers()
+    {
+        for (std::vector < Container* >::const_iterator it =
+                 mContainers.begin(); it != mContainers.end(); ++it) {
+            delete *it;
+        }
+    }
+
+    void add(Container* container)
+    {
+        container->wait(mContainers.size());
+        mContainers.push_back(container);
+        mExigibilities.insert(
+            std::make_pair(std::make_pair(
+                               container->exigibilityDate().getValue(),
+                               mRank), container));
+        mRanks.push_back(mRank++);
+        mArrivalSum.add(container->arrivalDate().getValue());
+    }
+
+    bool empty() const
+    { return mContainers.empty(); }
+
+    Container* pop()
+    {
+        return empty() ? 0 : take(earliest()->slot());
+    }
+
+    /**
+     * The first arrived of the containers with the earliest exigibility
+     * date, which stays in the store; the store is not empty.
+     */
+    Container* earliest() const
+    { return mExigibilities.begin()->second; }
+
+    /**
+     * The container of row, which stays in the store.
+     */
+    Container* container(ContainerSlot row) const
+    { return mContainers[row]; }
+
+    /**
+     * Arrival rank of a waiting container.
+     */
+    unsigned long rank(const Container* container) const
+    { return mRanks[container->slot()]; }
+
+    /**
+     * Unlink and return the container of row.
+     */
+    Container* take(ContainerSlot row)
+    {
+        Container* container = mContainers[row];
+
+        remove(container);
+        return container;
+    }
+
+    /**
+     * Unlink the container if it is still waiting. The container is not
+     * deleted: its owner is whoever took it out of the store.
+     */
+    void remove(Container* container)
+    {
+        if (container->waiting()) {
+            ContainerSlot row = container->slot();
+            ContainerSlot last = size() - 1;
+
+            mExigibilities.erase(std::make_pair(
+                                     container->exigibilityDate().getValue(),
+                                     mRanks[row]));
+            if (row != last) {
+                mContainers[row] = mContainers[last];
+                mRanks[row] = mRanks[last];
+                mContainers[row]->wait(row);
+            }
+            mContainers.pop_back();
+            mRanks.pop_back();
+            container->leave();
+            mArrivalSum.subtract(container->arrivalDate().getValue());
+        }
+    }
+
+    std::size_t size() const
+    { return mContainers.size(); }
+
+    /**
+     * Write the waiting containers in arrival order, so that restore()
+     * gives them the same relative ranks.
+     */
+    void save(CheckpointWriter& out) const
+    {
+        std::vector < std::pair < unsigned long, Container* > > rows;
+
+        for (ContainerSlot i = 0; i < size(); ++i) {
+            rows.push_back(std::make_pair(mRanks[i], mContainers[i]));
+        }
+        std::sort(rows.begin(), rows.end());
+        out.write((boost::uint32_t)rows.size());
+        for (ContainerSlot i = 0; i < rows.size(); ++i) {
+            rows[i].second->save(out);
+        }
+    }
+
+    /**
+     * Add the containers written by save(), created in pool.
+     */
+    void restore(CheckpointReader& in, ObjectPool& pool)
+    {
+        boost::uint32_t n = in.get < boost::uint32_t >();
+
+        for (boost::uint32_t i = 0; i < n; ++i) {
+            add(new (pool) Container(in));
+        }
+    }
+
+    /**
+     * Sum over the waiting containers of the time spent in the zone, from
+     * the exact sum of the arrival dates: containers only wait from their
+     * arrival on, so none of them has a date in the future.
+     */
+    double timeInTransit(const Time& time) const
+    { return mArrivalSum.elapsed(size(), time.getValue()); }
+
+private:
+    typedef std::map < std::pair < double, unsigned long >,
+                       Container* > ExigibilityIndex;
+
+    std::vector < Container* > mContainers;
+    std::vector < unsigned long > mRanks;
+    ExigibilityIndex mExigibilities;
+    unsigned long mRank;
+    ExactSum mArrivalSum;
+};
+
 } // namespace logistics
 
 #endif
@@ -22,7 +22,7 @@
  */
 
 #include <vle/devs/Dynamics.hpp>
-#include <Transport.hpp>
+#include <Payload.hpp>
 
 namespace logistics {
 
@@ -31,9 +31,16 @@ class Decision : public vle::devs::Dynamics
 public:
     Decision(const vle::devs::DynamicsInit& init,
           const vle::devs::InitEventList& events) :
-        vle::devs::Dynamics(init, events)
+        vle::devs::Dynamics(init, events),
+        mSimulation(Simulation::acquire(getModel(), events)),
+        mLog(getModelName(), events)
     { }
 
+    virtual ~Decision()
+    {
+        Simulation::release(mSimulation);
+    }
+
     void removeWaitingTransport(unsigned int ID)
     {
         bool found = false;
@@ -52,148 +59,158 @@ public:
         }
     }
 
-    void searchTransport(const vle::devs::Time& time)
+    void searchTransports(const vle::devs::Time& time)
     {
-        bool found = false;
-        Transports::const_iterator it = mTransports.begin();
-
-        std::cout << time << " - [" << getModelName()
-                  << "] DECISION: SEARCH TRANSPORT";
-
-        mSelectedArrivedTransport = 0;
-        while (not found and it != mTransports.end()) {
-            double e = std::abs((*it)->departureDate() - time);
-
-            if (e < 1e-5) {
-                found = true;
-            } else {
-                ++it;
+        mSelectedTransports.clear();
+        mTransports.due(time, TOLERANCE, mSelectedTransports);
+        if (mSelectedTransports.empty()) {
+            LOGISTICS_ERROR(mLog, time, "DECISION: SEARCH TRANSPORT"
+                            " => NOT FOUND ---> PB !!!!!!");
+        } else if (mLog.enabled(LEVEL_INFO)) {
+            LogRecord record(mLog, time);
+
+            record.stream() << "DECISION: SEARCH TRANSPORT =>";
+            for (SelectedTransports::const_iterator it =
+                     mSelectedTransports.begin();
+                 it != mSelectedTransports.end(); ++it) {
+                record.stream() << " " << (*it)->id();
             }
         }
-        if (found) {
-            mSelectedArrivedTransport = *it;
-
-            std::cout << " => " << mSelectedArrivedTransport->id()
-                      << std::endl;
-
-        } else {
-            std::cout << " => NOT FOUND ---> PB !!!!!!" << std::endl;
-        }
     }
 
+    /*
+     * A transport that arrives after its departure date is loaded at
+     * once rather than scheduled in the past.
+     */
     void updateSigma(const vle::devs::Time& time)
     {
         if (mTransports.empty()) {
             mSigma = vle::devs::Time::infinity;
+        } else if (mTransports.next() < time) {
+            mSigma = 0;
         } else {
-            vle::devs::Time t = vle::devs::Time::infinity;
-            Transports::const_iterator it = mTransports.begin();
-
-            while (it != mTransports.end()) {
-                if ((*it)->departureDate() < t) {
-                    t = (*it)->departureDate();
-                }
-                ++it;
-            }
-            if (mPhase == SEND_LOAD or mSigma > t - time) {
-                mSigma = t - time;
-            }
+            mSigma = mTransports.next() - time;
         }
     }
 
-    void waitContainer()
+    void waitContainers()
     {
-        bool found = false;
-        Transports::iterator it = mTransports.begin();
-
-        while (not found and it != mTransports.end()) {
-            if ((*it) == mSelectedArrivedTransport) {
-                found = true;
-            } else {
-                ++it;
-            }
-        }
-        if (found) {
+        for (SelectedTransports::const_iterator it =
+                 mSelectedTransports.begin();
+             it != mSelectedTransports.end(); ++it) {
+            mTransports.remove(*it);
             mWaitingTransports.push_back(*it);
-            mTransports.erase(it);
-            mSelectedArrivedTransport = 0;
         }
+        mSelectedTransports.clear();
     }
 
 /*  - - - - - - - - - - - - - --ooOoo-- - - - - - - - - - - -  */
 
-    vle::devs::Time init(const vle::devs::Time& /* time */)
+    /*
+     * A restored Decision recomputes its sigma from the departure dates
+     * of its transports.
+     */
+    vle::devs::Time init(const vle::devs::Time& time)
     {
-        mPhase = IDLE;
         mSigma = vle::devs::Time::infinity;
-        return vle::devs::Time::infinity;
+        if (const Checkpoint* checkpoint = mSimulation.restored(time)) {
+            CheckpointReader in(*checkpoint, getModel());
+
+            mTransports.restore(in, mSimulation.transports());
+            mWaitingTransports.restore(in, mSimulation.transports());
+            mReadyTransports.restore(in, mSimulation.transports());
+            updateSigma(time);
+        }
+        return timeAdvance();
     }
 
+    void finish()
+    {
+        if (Checkpoint* checkpoint = mSimulation.checkpoint()) {
+            CheckpointWriter out(*checkpoint, getModel());
+
+            mTransports.save(out);
+            mWaitingTransports.save(out);
+            mReadyTransports.save(out);
+        }
+    }
+
+    /*
+     * The transports due at time are sent to be loaded in the step that
+     * finds them, along with the departures of the transports loaded
+     * since the last step: an external transition cannot emit, so a
+     * departure still takes one transition of zero duration after the
+     * "loaded" event.
+     */
     void output(const vle::devs::Time& time,
                 vle::devs::ExternalEventList& output) const
     {
-        if (mPhase == SEND_LOAD) {
+        // the transports DepartureSchedule::due would select, without
+        // copying them
+        for (DepartureSchedule::const_iterator it = mTransports.begin();
+             it != mTransports.end() and it->first - time < TOLERANCE;
+             ++it) {
             vle::devs::ExternalEvent* ee =
                 new vle::devs::ExternalEvent("load");
 
-            std::cout << time << " - [" << getModelName()
-                      << "] DECISION LOAD: "
-                      << mSelectedArrivedTransport->toString() << std::endl;
+            LOGISTICS_INFO(mLog, time, "DECISION LOAD: "
+                           << it->second->toString());
 
+            ee << vle::devs::attribute("type", it->second->contentType());
             ee << vle::devs::attribute(
-                "type",mSelectedArrivedTransport->contentType());
-            ee << vle::devs::attribute("transport",
-                                       mSelectedArrivedTransport->toValue());
+                "transport", new TransportPayload(
+                    TransportHandle(new (mSimulation.transports())
+                                    Transport(*it->second))));
             output.addEvent(ee);
-        } else if (mPhase == SEND_DEPART) {
+        }
+        if (not mReadyTransports.empty()) {
             Transports::const_iterator it = mReadyTransports.begin();
 
-            std::cout << time << " - [" << getModelName()
-                      << "] DECISION DEPART: { ";
-
             while (it != mReadyTransports.end()) {
                 vle::devs::ExternalEvent* ee =
                     new vle::devs::ExternalEvent("depart");
 
-                std::cout << (*it)->id() << " ";
                 ee << vle::devs::attribute("type", (*it)->contentType());
                 ee << vle::devs::attribute("id", (int)(*it)->id());
                 output.addEvent(ee);
                 ++it;
             }
+            if (mLog.enabled(LEVEL_INFO)) {
+                LogRecord record(mLog, time);
 
-            std::cout << "}" << std::endl;
-
+                record.stream() << "DECISION DEPART: { ";
+                for (it = mReadyTransports.begin();
+                     it != mReadyTransports.end(); ++it) {
+                    record.stream() << (*it)->id() << " ";
+                }
+                record.stream() << "}";
+            }
         }
     }
 
     vle::devs::Time timeAdvance() const
     {
-        if (mPhase == SEND_DEPART or mPhase == SEND_LOAD) {
-            return 0;
-        } else {
+        if (mReadyTransports.empty()) {
             return mSigma;
+        } else {
+            return 0;
         }
     }
 
     void internalTransition(const vle::devs::Time& time)
     {
-
-        std::cout.precision(12);
-        std::cout << time << " - [" << getModelName()
-                  << "] internalTransition: " << mPhase << std::endl;
-
-        if (mPhase == IDLE) {
-            searchTransport(time);
-            mPhase = SEND_LOAD;
-        } else if (mPhase == SEND_LOAD) {
-            waitContainer();
-            updateSigma(time);
-            mPhase = IDLE;
-        } else if (mPhase == SEND_DEPART) {
-            mReadyTransports.clear();
-            mPhase = IDLE;
+        mSimulation.transition(time);
+        LOGISTICS_DEBUG(mLog, time, "internalTransition: "
+                        << mReadyTransports.size() << " ready");
+
+        // woken up either by a departure date or by a loaded transport
+        if (mReadyTransports.empty() or
+            mTransports.next() - time < TOLERANCE) {
+            searchTransports(time);
+            waitContainers();
         }
+        mReadyTransports.clear();
+        updateSigma(time);
     }
 
     void externalTransition(
@@ -201,32 +218,32 @@ public:
     {
         vle::devs::ExternalEventList::const_iterator it = events.begin();
 
-        std::cout.precision(12);
-        std::cout << time << " - [" << getModelName()
-                  << "] externalTransition: " << mPhase << std::endl;
+        mSimulation.received(events.size());
+        mSimulation.transition(time);
+
+        LOGISTICS_DEBUG(mLog, time, "externalTransition: "
+                        << mReadyTransports.size() << " ready");
 
         while (it != events.end()) {
             if ((*it)->onPort("transport")) {
-                Transport* transport = new Transport(
-                    vle::value::toMapValue(
-                        (*it)->getAttributeValue("transport")));
+                Transport* transport =
+                    new (mSimulation.transports()) Transport(
+                        *toTransport((*it)->getAttributeValue("transport"),
+                                     mSimulation));
 
-                std::cout << time << " - [" << getModelName()
-                          << "] DECISION TRANSPORT: " << transport->toString()
-                          << " => " << mPhase << std::endl;
+                LOGISTICS_INFO(mLog, time, "DECISION TRANSPORT: "
+                               << transport->toString());
 
                 transport->arrived(time);
-                mTransports.push_back(transport);
+                mTransports.add(transport);
             } else if ((*it)->onPort("loaded")) {
                 TransportID transportID =
                     (*it)->getIntegerAttributeValue("id");
 
-                std::cout << time << " - [" << getModelName()
-                          << "] DECISION LOADED: transport -> " << transportID
-                          << std::endl;
+                LOGISTICS_INFO(mLog, time, "DECISION LOADED: transport -> "
+                               << transportID);
 
                 removeWaitingTransport(transportID);
-                mPhase = SEND_DEPART;
             }
             ++it;
         }
@@ -246,17 +263,23 @@ public:
     }
 
 private:
-    enum phase { IDLE, SEND_LOAD, SEND_DEPART };
+    typedef std::vector < Transport* > SelectedTransports;
+
+    Simulation& mSimulation;
+    Logger mLog;
+
+    static const double TOLERANCE;
 
     // state
-    phase mPhase;
     vle::devs::Time mSigma;
-    Transports mTransports;
-    Transport* mSelectedArrivedTransport;
+    DepartureSchedule mTransports;
+    SelectedTransports mSelectedTransports;
     Transports mWaitingTransports;
     Transports mReadyTransports;
 };
 
+const double Decision::TOLERANCE = 1e-5;
+
 } // namespace logistics
 
 DECLARE_NAMED_DYNAMICS(Decision, logistics::Decision);
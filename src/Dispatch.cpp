@@ -22,8 +22,9 @@
  */
 
 #include <vle/devs/Dynamics.hpp>
-#include <Container.hpp>
+#include <Payload.hpp>
 #include <list>
+#include <map>
 
 namespace logistics {
 
@@ -32,28 +33,59 @@ class Dispatch : public vle::devs::Dynamics
 public:
     Dispatch(const vle::devs::DynamicsInit& init,
              const vle::devs::InitEventList& events) :
-        vle::devs::Dynamics(init, events)
+        vle::devs::Dynamics(init, events),
+        mSimulation(Simulation::acquire(getModel(), events)),
+        mLog(getModelName(), events)
     {
     }
 
-    vle::devs::ExternalEvent* cloneExternalEvent(
-        vle::devs::ExternalEvent* event, const std::string& portName) const
+    virtual ~Dispatch()
     {
-        vle::devs::ExternalEvent* ee = new vle::devs::ExternalEvent(
-            portName);
-        vle::value::Map::const_iterator it = event->getAttributes().begin();
+        Simulation::release(mSimulation);
+    }
 
-        while (it != event->getAttributes().end()) {
-            ee->putAttribute(it->first, it->second->clone());
-            ++it;
+    const std::string& portName(const std::string& port, ContentType type)
+    {
+        PortNames::iterator it = mPortNames.find(port);
+
+        if (it == mPortNames.end()) {
+            it = mPortNames.insert(
+                std::make_pair(port, std::make_pair(
+                                   (vle::fmt("%1%_Food") % port).str(),
+                                   (vle::fmt("%1%_NoFood") % port).str())))
+                .first;
         }
-        return ee;
+        return type == FOOD ? it->second.first : it->second.second;
     }
 
-    vle::devs::Time init(const vle::devs::Time& /* time */)
+    vle::devs::Time init(const vle::devs::Time& time)
     {
         mPhase = IDLE;
-        return vle::devs::Time::infinity;
+        if (const Checkpoint* checkpoint = mSimulation.restored(time)) {
+            CheckpointReader in(*checkpoint, getModel());
+            boost::uint32_t n;
+
+            mPhase = (phase)in.get < boost::uint8_t >();
+            in.read(n);
+            for (boost::uint32_t i = 0; i < n; ++i) {
+                mEvents.push_back(restoreEvent(in, mSimulation));
+            }
+        }
+        return timeAdvance();
+    }
+
+    void finish()
+    {
+        if (Checkpoint* checkpoint = mSimulation.checkpoint()) {
+            CheckpointWriter out(*checkpoint, getModel());
+
+            out.write((boost::uint8_t)mPhase);
+            out.write((boost::uint32_t)mEvents.size());
+            for (events::const_iterator it = mEvents.begin();
+                 it != mEvents.end(); ++it) {
+                saveEvent(out, **it, mLog, mSimulation.date());
+            }
+        }
     }
 
     void output(const vle::devs::Time& /* time */,
@@ -71,8 +103,9 @@ public:
         else return 0;
     }
 
-    void internalTransition(const vle::devs::Time& /* time */)
+    void internalTransition(const vle::devs::Time& time)
     {
+        mSimulation.transition(time);
         mEvents.clear();
         mPhase = IDLE;
     }
@@ -83,24 +116,24 @@ public:
     {
         vle::devs::ExternalEventList::const_iterator it = events.begin();
 
+        mSimulation.received(events.size());
+        mSimulation.transition(time);
+
         while (it != events.end()) {
             ContentType type;
 
-            if ((*it)->onPort("container")) {
-                Container container(vle::value::toMapValue(
-                                        (*it)->getAttributeValue("container")));
-
-                type = container.type();
+            // a batch of containers from Split carries its type, as the
+            // load and depart events do
+            if ((*it)->onPort("container") and
+                not (*it)->existAttributeValue("containers")) {
+                type = containerType((*it)->getAttributeValue("container"));
             } else {
                 type = (ContentType)(
                     (*it)->getIntegerAttributeValue("type"));
             }
 
-            std::string portName =
-                (vle::fmt("%1%_%2%") % (*it)->getPortName() %
-                 (type == FOOD ? "Food" : "NoFood")).str();
-
-            mEvents.push_back(cloneExternalEvent(*it, portName));
+            mEvents.push_back(
+                forwardEvent(**it, portName((*it)->getPortName(), type)));
             ++it;
         }
         mPhase = SEND;
@@ -111,6 +144,15 @@ private:
 
     typedef std::list < vle::devs::ExternalEvent* > events;
 
+    typedef std::map < std::string,
+                       std::pair < std::string, std::string > > PortNames;
+
+    // output port names of each input port, filled on first use
+    PortNames mPortNames;
+
+    Simulation& mSimulation;
+    Logger mLog;
+
     // state
     phase mPhase;
     events mEvents;
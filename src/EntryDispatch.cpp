@@ -22,7 +22,7 @@
  */
 
 #include <vle/devs/Dynamics.hpp>
-#include <Transport.hpp>
+#include <Payload.hpp>
 #include <list>
 
 namespace logistics {
@@ -32,27 +32,48 @@ class EntryDispatch : public vle::devs::Dynamics
 public:
     EntryDispatch(const vle::devs::DynamicsInit& init,
               const vle::devs::InitEventList& events) :
-        vle::devs::Dynamics(init, events)
-    { }
+        vle::devs::Dynamics(init, events),
+        mSimulation(Simulation::acquire(getModel(), events)),
+        mLog(getModelName(), events)
+    {
+        mPortNames[BOAT] = "boat";
+        mPortNames[TRUCK] = "truck";
+        mPortNames[TRAIN] = "train";
+    }
 
-    vle::devs::ExternalEvent* cloneExternalEvent(
-        vle::devs::ExternalEvent* event, const std::string& portName) const
+    virtual ~EntryDispatch()
     {
-        vle::devs::ExternalEvent* ee = new vle::devs::ExternalEvent(
-            portName);
-        vle::value::Map::const_iterator it = event->getAttributes().begin();
+        Simulation::release(mSimulation);
+    }
 
-        while (it != event->getAttributes().end()) {
-            ee->putAttribute(it->first, it->second->clone());
-            ++it;
+    vle::devs::Time init(const vle::devs::Time& time)
+    {
+        mPhase = IDLE;
+        if (const Checkpoint* checkpoint = mSimulation.restored(time)) {
+            CheckpointReader in(*checkpoint, getModel());
+            boost::uint32_t n;
+
+            mPhase = (phase)in.get < boost::uint8_t >();
+            in.read(n);
+            for (boost::uint32_t i = 0; i < n; ++i) {
+                mEvents.push_back(restoreEvent(in, mSimulation));
+            }
         }
-        return ee;
+        return timeAdvance();
     }
 
-    vle::devs::Time init(const vle::devs::Time& /* time */)
+    void finish()
     {
-        mPhase = IDLE;
-        return vle::devs::Time::infinity;
+        if (Checkpoint* checkpoint = mSimulation.checkpoint()) {
+            CheckpointWriter out(*checkpoint, getModel());
+
+            out.write((boost::uint8_t)mPhase);
+            out.write((boost::uint32_t)mEvents.size());
+            for (events::const_iterator it = mEvents.begin();
+                 it != mEvents.end(); ++it) {
+                saveEvent(out, **it, mLog, mSimulation.date());
+            }
+        }
     }
 
     void output(const vle::devs::Time& /* time */,
@@ -70,8 +91,9 @@ public:
         else return 0;
     }
 
-    void internalTransition(const vle::devs::Time& /* time */)
+    void internalTransition(const vle::devs::Time& time)
     {
+        mSimulation.transition(time);
         mEvents.clear();
         mPhase = IDLE;
     }
@@ -82,25 +104,28 @@ public:
     {
         vle::devs::ExternalEventList::const_iterator it = events.begin();
 
+        mSimulation.received(events.size());
+        mSimulation.transition(time);
+
         while (it != events.end()) {
 
             if ((*it)->onPort("in")) {
-                Transport transport(vle::value::toMapValue(
-                                        (*it)->getAttributeValue("transport")));
-                std::string portName;
-
-                if (transport.type() == BOAT) {
-                    portName = "boat";
-                } else if (transport.type() == TRUCK) {
-                    portName = "truck";
-                } else if (transport.type() == TRAIN) {
-                    portName = "train";
-                }
-                mEvents.push_back(cloneExternalEvent(*it, portName));
+                int type = transportType(
+                    (*it)->getAttributeValue("transport"));
 
-                std::cout << time << " - [" << getModelName()
-                          << "] ENTRY DISPTACH: " << portName << std::endl;
+                if (type < BOAT or type > TRAIN) {
+                    // a foreign transport of no known type has no port
+                    LOGISTICS_ERROR(mLog, time, "ENTRY DISPTACH: transport"
+                                    " of unknown type " << type
+                                    << " ignored");
+                } else {
+                    const std::string& portName = mPortNames[type];
 
+                    mEvents.push_back(forwardEvent(**it, portName));
+
+                    LOGISTICS_INFO(mLog, time, "ENTRY DISPTACH: "
+                                   << portName);
+                }
             }
             ++it;
         }
@@ -112,6 +137,12 @@ private:
 
     typedef std::list < vle::devs::ExternalEvent* > events;
 
+    // output port name of each transport type
+    std::string mPortNames[TRAIN + 1];
+
+    Simulation& mSimulation;
+    Logger mLog;
+
     // state
     phase mPhase;
     events mEvents;
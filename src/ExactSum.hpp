@@ -0,0 +1,161 @@
+/**
+ * @file ExactSum.hpp
+ * @author The VLE Development Team
+ * See the AUTHORS or Authors.txt file
+ */
+
+/*
+ * Copyright (C) 2012 ULCO http://www.univ-littoral.fr
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef EXACTSUM_HPP
+#define EXACTSUM_HPP 1
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+namespace logistics {
+
+/**
+ * Exact running sum of finite doubles, kept as non-overlapping partial
+ * sums of increasing magnitude (Shewchuk, "Adaptive Precision
+ * Floating-Point Arithmetic", 1997): adding and subtracting lose nothing,
+ * whatever the order, and the result is rounded once. The aggregates
+ * built on it give the correctly rounded value of the sum they replace.
+ */
+class ExactSum
+{
+public:
+    void add(double x)
+    { grow(mPartials, x); }
+
+    void subtract(double x)
+    { grow(mPartials, -x); }
+
+    void clear()
+    { mPartials.clear(); }
+
+    /**
+     * The sum, correctly rounded.
+     */
+    double value() const
+    { return round(mPartials); }
+
+    /**
+     * count * time minus the sum, correctly rounded: the time elapsed at
+     * time since the count dates of the sum.
+     */
+    double elapsed(unsigned long count, double time) const
+    {
+        double product = (double)count * time;
+
+        mScratch.resize(mPartials.size());
+        for (std::size_t i = 0; i < mPartials.size(); ++i) {
+            mScratch[i] = -mPartials[i];
+        }
+        grow(mScratch, product);
+        grow(mScratch, productError(count, time, product));
+        return round(mScratch);
+    }
+
+private:
+    static void grow(std::vector < double >& partials, double x)
+    {
+        std::size_t n = 0;
+
+        for (std::size_t i = 0; i < partials.size(); ++i) {
+            double y = partials[i];
+
+            if (std::fabs(x) < std::fabs(y)) {
+                std::swap(x, y);
+            }
+
+            double high = x + y;
+            double low = y - (high - x);
+
+            if (low != 0) {
+                partials[n++] = low;
+            }
+            x = high;
+        }
+        partials.resize(n);
+        partials.push_back(x);
+    }
+
+    static double round(const std::vector < double >& partials)
+    {
+        std::size_t n = partials.size();
+        double high = 0;
+        double low = 0;
+
+        if (n == 0) {
+            return 0;
+        }
+        high = partials[--n];
+        while (n > 0) {
+            double x = high;
+            double y = partials[--n];
+
+            high = x + y;
+            low = y - (high - x);
+            if (low != 0) {
+                break;
+            }
+        }
+        // half-way case: the partials left decide the direction
+        if (n > 0 and ((low < 0 and partials[n - 1] < 0) or
+                       (low > 0 and partials[n - 1] > 0))) {
+            double y = low * 2;
+            double x = high + y;
+
+            if (y == x - high) {
+                high = x;
+            }
+        }
+        return high;
+    }
+
+    /**
+     * Rounding error of product = a * b (Dekker's two-product).
+     */
+    static double productError(double a, double b, double product)
+    {
+        double ah, al, bh, bl;
+
+        split(a, ah, al);
+        split(b, bh, bl);
+        return ((ah * bh - product) + ah * bl + al * bh) + al * bl;
+    }
+
+    static void split(double a, double& high, double& low)
+    {
+        double c = 134217729. * a; // 2^27 + 1
+
+        high = c - (c - a);
+        low = a - high;
+    }
+
+    std::vector < double > mPartials;
+
+    // reused by elapsed()
+    mutable std::vector < double > mScratch;
+};
+
+} // namespace logistics
+
+#endif
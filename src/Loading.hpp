@@ -0,0 +1,163 @@
+/**
+ * @file Loading.hpp
+ * @author The VLE Development Team
+ * See the AUTHORS or Authors.txt file
+ */
+
+/*
+ * Copyright (C) 2012 ULCO http://www.univ-littoral.fr
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LOADING_HPP
+#define LOADING_HPP 1
+
+#include <Container.hpp>
+#include <Transport.hpp>
+#include <limits>
+#include <map>
+
+namespace logistics {
+
+/*
+ * Loading policies of the transit zones: Transit is a template over one
+ * of them (see Transit.cpp). Each policy keeps its own ordered index of
+ * the waiting containers, which Transit feeds as containers arrive and
+ * leave: add() and remove() take the container and its arrival rank,
+ * and select() returns, without taking it, the waiting container to
+ * load next onto transport; the store is not empty. Selecting is then
+ * logarithmic at worst, and the policies are only called through their
+ * type, so the calls are inlined in the loading loop. Transports are
+ * filled in arrival order whatever the policy.
+ */
+
+/**
+ * Earliest exigibility date first, then first arrived: the order of the
+ * index of the store itself.
+ */
+struct EarliestExigibility
+{
+    void add(Container* /* container */, unsigned long /* rank */)
+    { }
+
+    void remove(const Container* /* container */, unsigned long /* rank */)
+    { }
+
+    Container* select(const WaitingContainers& containers,
+                      const Transport& /* transport */) const
+    { return containers.earliest(); }
+};
+
+/**
+ * First arrived, first loaded.
+ */
+class FirstInFirstOut
+{
+public:
+    void add(Container* container, unsigned long rank)
+    { mIndex.insert(mIndex.end(), std::make_pair(rank, container)); }
+
+    void remove(const Container* /* container */, unsigned long rank)
+    { mIndex.erase(rank); }
+
+    Container* select(const WaitingContainers& /* containers */,
+                      const Transport& /* transport */) const
+    { return mIndex.begin()->second; }
+
+private:
+    std::map < unsigned long, Container* > mIndex;
+};
+
+/**
+ * The containers going where the transport goes first, by earliest
+ * exigibility date; the others, as EarliestExigibility, when none does.
+ */
+class DestinationMatching
+{
+public:
+    void add(Container* container, unsigned long rank)
+    { mIndex.insert(std::make_pair(key(container, rank), container)); }
+
+    void remove(const Container* container, unsigned long rank)
+    { mIndex.erase(key(container, rank)); }
+
+    Container* select(const WaitingContainers& containers,
+                      const Transport& transport) const
+    {
+        Index::const_iterator it = mIndex.lower_bound(
+            Key(transport.destination(),
+                std::make_pair(-std::numeric_limits < double >::infinity(),
+                               0ul)));
+
+        return it != mIndex.end() and
+            it->first.first == transport.destination() ?
+            it->second : containers.earliest();
+    }
+
+private:
+    // destination, exigibility date, rank
+    typedef std::pair < LocationID,
+                        std::pair < double, unsigned long > > Key;
+    typedef std::map < Key, Container* > Index;
+
+    static Key key(const Container* container, unsigned long rank)
+    {
+        return Key(container->destination(),
+                   std::make_pair(container->exigibilityDate().getValue(),
+                                  rank));
+    }
+
+    Index mIndex;
+};
+
+/**
+ * Earliest exigibility date, brought forward by Weight percent of the
+ * time the container has waited in the zone: a container that waited
+ * long passes more urgent ones that just arrived. Since the current
+ * time weighs the same on every container, the key reduces to the
+ * exigibility date plus Weight percent of the arrival date, which does
+ * not change while the container waits.
+ */
+template < unsigned int Weight >
+class LatenessWeighted
+{
+public:
+    void add(Container* container, unsigned long rank)
+    { mIndex.insert(std::make_pair(key(container, rank), container)); }
+
+    void remove(const Container* container, unsigned long rank)
+    { mIndex.erase(key(container, rank)); }
+
+    Container* select(const WaitingContainers& /* containers */,
+                      const Transport& /* transport */) const
+    { return mIndex.begin()->second; }
+
+private:
+    typedef std::pair < double, unsigned long > Key;
+
+    static Key key(const Container* container, unsigned long rank)
+    {
+        const double weight = Weight / 100.;
+
+        return Key(container->exigibilityDate().getValue() +
+                   weight * container->arrivalDate().getValue(), rank);
+    }
+
+    std::map < Key, Container* > mIndex;
+};
+
+} // namespace logistics
+
+#endif
@@ -0,0 +1,93 @@
+/**
+ * @file Location.hpp
+ * @author The VLE Development Team
+ * See the AUTHORS or Authors.txt file
+ */
+
+/*
+ * Copyright (C) 2012 ULCO http://www.univ-littoral.fr
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LOCATION_HPP
+#define LOCATION_HPP 1
+
+#include <boost/thread/mutex.hpp>
+#include <boost/unordered_map.hpp>
+#include <deque>
+#include <string>
+
+namespace logistics {
+
+typedef unsigned int LocationID;
+
+/**
+ * Process-wide interning table of platform names. Models intern the
+ * names found in their conditions once, at construction, and then route
+ * on the dense identifiers; names are only looked up again to build
+ * output. The table is shared by every simulation of the process, hence
+ * the lock.
+ */
+class Locations
+{
+public:
+    static LocationID id(const std::string& name)
+    {
+        Locations& locations = instance();
+        boost::mutex::scoped_lock lock(locations.mMutex);
+        Index::const_iterator it = locations.mIndex.find(name);
+
+        if (it != locations.mIndex.end()) {
+            return it->second;
+        }
+
+        LocationID id = locations.mNames.size();
+
+        locations.mNames.push_back(name);
+        locations.mIndex[name] = id;
+        return id;
+    }
+
+    static const std::string& name(LocationID id)
+    {
+        Locations& locations = instance();
+        boost::mutex::scoped_lock lock(locations.mMutex);
+
+        // a deque never moves its elements on push_back, so the reference
+        // outlives the lock
+        return locations.mNames.at(id);
+    }
+
+private:
+    typedef boost::unordered_map < std::string, LocationID > Index;
+
+    Locations()
+    { }
+
+    static Locations& instance()
+    {
+        static Locations locations;
+
+        return locations;
+    }
+
+    boost::mutex mMutex;
+    std::deque < std::string > mNames;
+    Index mIndex;
+};
+
+} // namespace logistics
+
+#endif
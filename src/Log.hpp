@@ -0,0 +1,269 @@
+/**
+ * @file Log.hpp
+ * @author The VLE Development Team
+ * See the AUTHORS or Authors.txt file
+ */
+
+/*
+ * Copyright (C) 2012 ULCO http://www.univ-littoral.fr
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LOG_HPP
+#define LOG_HPP 1
+
+#include <vle/devs/Dynamics.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace logistics {
+
+enum LogLevel { LEVEL_QUIET = 0, LEVEL_ERROR = 1, LEVEL_INFO = 2,
+                LEVEL_DEBUG = 3 };
+
+/*
+ * Highest level compiled in. Building with -DLOGISTICS_LOG_LEVEL_MAX=0
+ * turns every LOGISTICS_INFO and LOGISTICS_DEBUG into dead code.
+ */
+#ifndef LOGISTICS_LOG_LEVEL_MAX
+#define LOGISTICS_LOG_LEVEL_MAX 3
+#endif
+
+/**
+ * Process-wide destination of the log lines. Models hand over complete
+ * lines, which are appended to a buffer under a short lock; a writer
+ * thread, woken every BATCH lines or at the latest every period(), swaps
+ * the buffer out and writes it to the standard output, so the
+ * simulation never waits on the stream.
+ */
+class LogSink : private boost::noncopyable
+{
+public:
+    static LogSink& instance()
+    {
+        static LogSink sink;
+
+        return sink;
+    }
+
+    /**
+     * Queue line, which must end with a newline. The string is taken
+     * over: line is left empty.
+     */
+    void write(std::string& line)
+    {
+        boost::mutex::scoped_lock lock(mMutex);
+
+        if (not mWriter) {
+            mWriter = new boost::thread(&LogSink::run, this);
+        }
+        mPending.push_back(std::string());
+        mPending.back().swap(line);
+        if (mPending.size() == BATCH) {
+            mReady.notify_one();
+        }
+    }
+
+    /**
+     * Wait until every line queued so far has been written.
+     */
+    void flush()
+    {
+        boost::mutex::scoped_lock lock(mMutex);
+
+        mReady.notify_one();
+        while (not mPending.empty() or mWriting) {
+            mDrained.wait(lock);
+        }
+    }
+
+private:
+    static const std::size_t BATCH = 1024;
+
+    static boost::posix_time::time_duration period()
+    { return boost::posix_time::milliseconds(100); }
+
+    LogSink() :
+        mWriter(0), mWriting(false), mStop(false)
+    { }
+
+    ~LogSink()
+    {
+        {
+            boost::mutex::scoped_lock lock(mMutex);
+
+            mStop = true;
+            mReady.notify_one();
+        }
+        if (mWriter) {
+            mWriter->join();
+            delete mWriter;
+        }
+    }
+
+    void run()
+    {
+        std::vector < std::string > lines;
+        boost::mutex::scoped_lock lock(mMutex);
+
+        for (;;) {
+            while (mPending.empty() and not mStop) {
+                mReady.timed_wait(lock, period());
+            }
+            if (mPending.empty()) {
+                return;
+            }
+            lines.swap(mPending);
+            mWriting = true;
+            lock.unlock();
+
+            for (std::vector < std::string >::const_iterator it =
+                     lines.begin(); it != lines.end(); ++it) {
+                std::cout << *it;
+            }
+            std::cout.flush();
+            lines.clear();
+
+            lock.lock();
+            mWriting = false;
+            mDrained.notify_all();
+        }
+    }
+
+    boost::mutex mMutex;
+    boost::condition_variable mReady;
+    boost::condition_variable mDrained;
+    boost::thread* mWriter;
+    std::vector < std::string > mPending;
+    bool mWriting;
+    bool mStop;
+};
+
+/**
+ * Log level of one model: the "log-level" condition of the model if
+ * any, otherwise the LOGISTICS_LOG_LEVEL environment variable, otherwise
+ * info. Levels are quiet, error, info and debug.
+ */
+class Logger
+{
+public:
+    Logger(const std::string& model, const vle::devs::InitEventList& events) :
+        mModel(model), mLevel(LEVEL_INFO)
+    {
+        const char* level = std::getenv("LOGISTICS_LOG_LEVEL");
+
+        mStream.precision(12);
+        if (events.exist("log-level")) {
+            mLevel = parse(vle::value::toString(events.get("log-level")));
+        } else if (level) {
+            mLevel = parse(level);
+        }
+    }
+
+    bool enabled(LogLevel level) const
+    { return level <= LOGISTICS_LOG_LEVEL_MAX and level <= mLevel; }
+
+    LogLevel level() const
+    { return mLevel; }
+
+    const std::string& model() const
+    { return mModel; }
+
+    static LogLevel parse(const std::string& level)
+    {
+        if (level == "quiet") {
+            return LEVEL_QUIET;
+        } else if (level == "error") {
+            return LEVEL_ERROR;
+        } else if (level == "debug") {
+            return LEVEL_DEBUG;
+        } else {
+            return LEVEL_INFO;
+        }
+    }
+
+private:
+    friend class LogRecord;
+
+    std::string mModel;
+    LogLevel mLevel;
+
+    // reused by the records of the model, which a single thread simulates
+    mutable std::ostringstream mStream;
+};
+
+/**
+ * One log line, "time - [model] message", written in the stream of the
+ * logger and queued to the sink when the record is destroyed. Only build
+ * records guarded by Logger::enabled(), as the macros below do, and only
+ * one at a time per logger.
+ */
+class LogRecord : private boost::noncopyable
+{
+public:
+    LogRecord(const Logger& logger, const vle::devs::Time& time) :
+        mStream(logger.mStream)
+    {
+        mStream.str(std::string());
+        mStream << time << " - [" << logger.model() << "] ";
+    }
+
+    ~LogRecord()
+    {
+        mStream << '\n';
+
+        std::string line = mStream.str();
+
+        LogSink::instance().write(line);
+    }
+
+    std::ostream& stream()
+    { return mStream; }
+
+private:
+    std::ostringstream& mStream;
+};
+
+} // namespace logistics
+
+/*
+ * message is a chain of << operands, only evaluated when the level is
+ * enabled for the model:
+ *     LOGISTICS_INFO(mLog, time, "LOADED: " << transport->toString());
+ */
+#define LOGISTICS_LOG(logger, level, time, message)                     \
+    do {                                                                \
+        if ((logger).enabled(level)) {                                  \
+            logistics::LogRecord(logger, time).stream() << message;     \
+        }                                                               \
+    } while (0)
+
+#define LOGISTICS_ERROR(logger, time, message)                          \
+    LOGISTICS_LOG(logger, logistics::LEVEL_ERROR, time, message)
+
+#define LOGISTICS_INFO(logger, time, message)                           \
+    LOGISTICS_LOG(logger, logistics::LEVEL_INFO, time, message)
+
+#define LOGISTICS_DEBUG(logger, time, message)                          \
+    LOGISTICS_LOG(logger, logistics::LEVEL_DEBUG, time, message)
+
+#endif
@@ -22,7 +22,7 @@
  */
 
 #include <vle/devs/Dynamics.hpp>
-#include <Transport.hpp>
+#include <Payload.hpp>
 #include <list>
 
 namespace logistics {
@@ -32,27 +32,56 @@ class Move : public vle::devs::Dynamics
 public:
     Move(const vle::devs::DynamicsInit& init,
          const vle::devs::InitEventList& events) :
-        vle::devs::Dynamics(init, events)
+        vle::devs::Dynamics(init, events),
+        mSimulation(Simulation::acquire(getModel(), events)),
+        mLog(getModelName(), events)
     { }
 
-    vle::devs::ExternalEvent* cloneExternalEvent(
-        vle::devs::ExternalEvent* event, const std::string& portName) const
+    virtual ~Move()
     {
-        vle::devs::ExternalEvent* ee = new vle::devs::ExternalEvent(
-            portName);
-        vle::value::Map::const_iterator it = event->getAttributes().begin();
+        Simulation::release(mSimulation);
+    }
 
-        while (it != event->getAttributes().end()) {
-            ee->putAttribute(it->first, it->second->clone());
-            ++it;
+    const std::string& portName(LocationID destination)
+    {
+        if (destination >= mPortNames.size()) {
+            mPortNames.resize(destination + 1);
+        }
+        if (mPortNames[destination].empty()) {
+            mPortNames[destination] = (vle::fmt("to_%1%") %
+                                       Locations::name(destination)).str();
         }
-        return ee;
+        return mPortNames[destination];
     }
 
-    vle::devs::Time init(const vle::devs::Time& /* time */)
+    vle::devs::Time init(const vle::devs::Time& time)
     {
         mPhase = IDLE;
-        return vle::devs::Time::infinity;
+        if (const Checkpoint* checkpoint = mSimulation.restored(time)) {
+            CheckpointReader in(*checkpoint, getModel());
+            boost::uint32_t n;
+
+            mPhase = (phase)in.get < boost::uint8_t >();
+            in.read(n);
+            for (boost::uint32_t i = 0; i < n; ++i) {
+                mEvents.push_back(restoreEvent(in, mSimulation));
+            }
+        }
+        return timeAdvance();
+    }
+
+    void finish()
+    {
+        if (Checkpoint* checkpoint = mSimulation.checkpoint()) {
+            CheckpointWriter out(*checkpoint, getModel());
+
+            out.write((boost::uint8_t)mPhase);
+            out.write((boost::uint32_t)mEvents.size());
+            for (events::const_iterator it = mEvents.begin();
+                 it != mEvents.end(); ++it) {
+                saveEvent(out, **it, mLog, mSimulation.date());
+            }
+        }
     }
 
     void output(const vle::devs::Time& /* time */,
@@ -70,8 +99,9 @@ public:
         else return 0;
     }
 
-    void internalTransition(const vle::devs::Time& /* time */)
+    void internalTransition(const vle::devs::Time& time)
     {
+        mSimulation.transition(time);
         mEvents.clear();
         mPhase = IDLE;
     }
@@ -82,15 +112,16 @@ public:
     {
         vle::devs::ExternalEventList::const_iterator it = events.begin();
 
+        mSimulation.received(events.size());
+        mSimulation.transition(time);
+
         while (it != events.end()) {
 
             if ((*it)->onPort("in")) {
-                Transport transport(vle::value::toMapValue(
-                                        (*it)->getAttributeValue("transport")));
-                std::string portName =
-                    (vle::fmt("to_%1%") % transport.destination()).str();
+                LocationID destination = transportDestination(
+                    (*it)->getAttributeValue("transport"));
 
-                mEvents.push_back(cloneExternalEvent(*it, portName));
+                mEvents.push_back(forwardEvent(**it, portName(destination)));
             }
             ++it;
         }
@@ -102,6 +133,12 @@ private:
 
     typedef std::list < vle::devs::ExternalEvent* > events;
 
+    // output port name of each destination, filled on first use
+    std::vector < std::string > mPortNames;
+
+    Simulation& mSimulation;
+    Logger mLog;
+
     // state
     phase mPhase;
     events mEvents;
@@ -0,0 +1,459 @@
+/**
+ * @file Payload.hpp
+ * @author The VLE Development Team
+ * See the AUTHORS or Authors.txt file
+ */
+
+/*
+ * Copyright (C) 2012 ULCO http://www.univ-littoral.fr
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PAYLOAD_HPP
+#define PAYLOAD_HPP 1
+
+#include <vle/devs/ExternalEvent.hpp>
+#include <vle/value/Boolean.hpp>
+#include <vle/value/Double.hpp>
+#include <vle/value/Integer.hpp>
+#include <vle/value/Map.hpp>
+#include <vle/value/Set.hpp>
+#include <vle/value/String.hpp>
+#include <vle/value/User.hpp>
+#include <Container.hpp>
+#include <Simulation.hpp>
+#include <Transport.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <typeinfo>
+
+namespace logistics {
+
+/**
+ * Event attribute carrying a native, immutable object by shared handle.
+ * Cloning the attribute, as the kernel and the routers do, shares the
+ * object instead of copying it. Observers and any other consumer of the
+ * textual forms see the same Map or Set that toValue() builds.
+ */
+template < typename T >
+class Payload : public vle::value::User
+{
+public:
+    typedef boost::shared_ptr < const T > handle_type;
+
+    Payload(const handle_type& handle) :
+        mHandle(handle)
+    { }
+
+    virtual ~Payload()
+    { }
+
+    const handle_type& handle() const
+    { return mHandle; }
+
+    virtual vle::value::Value* clone() const
+    { return new Payload < T >(mHandle); }
+
+    virtual size_t id() const
+    { return reinterpret_cast < size_t >(&typeid(T)); }
+
+    virtual std::string name() const
+    { return typeid(T).name(); }
+
+    virtual void writeFile(std::ostream& out) const
+    {
+        boost::scoped_ptr < vle::value::Value > value(mHandle->toValue());
+
+        value->writeFile(out);
+    }
+
+    virtual void writeString(std::ostream& out) const
+    {
+        boost::scoped_ptr < vle::value::Value > value(mHandle->toValue());
+
+        value->writeString(out);
+    }
+
+    virtual void writeXml(std::ostream& out) const
+    {
+        boost::scoped_ptr < vle::value::Value > value(mHandle->toValue());
+
+        value->writeXml(out);
+    }
+
+private:
+    handle_type mHandle;
+};
+
+typedef Payload < Container > ContainerPayload;
+typedef Payload < SharedContainers > ContainersPayload;
+typedef Payload < Transport > TransportPayload;
+
+/*
+ * Attribute readers: the native handle when the attribute is a payload,
+ * otherwise an object built, in the pools of the simulation, from the
+ * Map or Set form sent by a foreign model.
+ */
+
+inline ContainerHandle toContainer(const vle::value::Value& value,
+                                   Simulation& simulation)
+{
+    const ContainerPayload* payload =
+        dynamic_cast < const ContainerPayload* >(&value);
+
+    return payload ? payload->handle() :
+        ContainerHandle(new (simulation.containers()) Container(
+                            vle::value::toMapValue(value)));
+}
+
+inline ContainersPayload::handle_type toContainers(
+    const vle::value::Value& value, Simulation& simulation)
+{
+    const ContainersPayload* payload =
+        dynamic_cast < const ContainersPayload* >(&value);
+
+    return payload ? payload->handle() :
+        ContainersPayload::handle_type(
+            new SharedContainers(vle::value::toSetValue(value),
+                                 simulation.containers()));
+}
+
+inline TransportHandle toTransport(const vle::value::Value& value,
+                                   Simulation& simulation)
+{
+    const TransportPayload* payload =
+        dynamic_cast < const TransportPayload* >(&value);
+
+    return payload ? payload->handle() :
+        TransportHandle(new (simulation.transports()) Transport(
+                            vle::value::toMapValue(value)));
+}
+
+/*
+ * Field readers for the routing decisions: one field of the payload, or
+ * one key of the Map form, without building the whole object.
+ */
+
+inline ContentType containerType(const vle::value::Value& value)
+{
+    const ContainerPayload* payload =
+        dynamic_cast < const ContainerPayload* >(&value);
+
+    return payload ? payload->handle()->type() :
+        (ContentType)vle::value::toInteger(
+            vle::value::toMapValue(value).get("ContentType"));
+}
+
+inline TransportType transportType(const vle::value::Value& value)
+{
+    const TransportPayload* payload =
+        dynamic_cast < const TransportPayload* >(&value);
+
+    return payload ? payload->handle()->type() :
+        (TransportType)vle::value::toInteger(
+            vle::value::toMapValue(value).get("Type"));
+}
+
+inline LocationID transportDestination(const vle::value::Value& value)
+{
+    const TransportPayload* payload =
+        dynamic_cast < const TransportPayload* >(&value);
+
+    return payload ? payload->handle()->destination() :
+        Locations::id(vle::value::toString(
+                          vle::value::toMapValue(value).get(
+                              "Destination")));
+}
+
+/**
+ * Copy of event on portName, for the routers. Every attribute is
+ * cloned, so that the models and observers after the router see it as
+ * it was sent: a payload clone is one small allocation sharing the
+ * native object, while a Map or Set sent by a foreign model is copied
+ * whole at each hop, as the routers always did.
+ */
+inline vle::devs::ExternalEvent* forwardEvent(
+    const vle::devs::ExternalEvent& event, const std::string& portName)
+{
+    vle::devs::ExternalEvent* ee = new vle::devs::ExternalEvent(portName);
+    vle::value::Map::const_iterator it = event.getAttributes().begin();
+
+    while (it != event.getAttributes().end()) {
+        ee->putAttribute(it->first, it->second->clone());
+        ++it;
+    }
+    return ee;
+}
+
+/*
+ * Events pending in a router, in checkpoints: the port, then each
+ * attribute by name, as a kind tag followed by the transport, container
+ * or manifest it holds, or by the value a foreign model sent: a boolean,
+ * number or string, or a set or map of those, written the same way.
+ * Payloads are written whole, so a restored event has its own copy of
+ * what the event shared. Other values cannot be written and are dropped
+ * from the checkpoint, with an error in the log.
+ */
+
+enum CheckpointAttribute { ATTRIBUTE_TRANSPORT, ATTRIBUTE_CONTAINER,
+                           ATTRIBUTE_CONTAINERS, ATTRIBUTE_INTEGER,
+                           ATTRIBUTE_DOUBLE, ATTRIBUTE_BOOLEAN,
+                           ATTRIBUTE_STRING, ATTRIBUTE_SET,
+                           ATTRIBUTE_MAP };
+
+/**
+ * Whether saveValue() can write value.
+ */
+inline bool savable(const vle::value::Value& value)
+{
+    switch (value.getType()) {
+    case vle::value::Value::BOOLEAN:
+    case vle::value::Value::INTEGER:
+    case vle::value::Value::DOUBLE:
+    case vle::value::Value::STRING:
+        return true;
+    case vle::value::Value::SET:
+    {
+        const vle::value::Set& set = vle::value::toSetValue(value);
+
+        for (vle::value::Set::const_iterator it = set.begin();
+             it != set.end(); ++it) {
+            if (not *it or not savable(**it)) {
+                return false;
+            }
+        }
+        return true;
+    }
+    case vle::value::Value::MAP:
+    {
+        const vle::value::Map& map = vle::value::toMapValue(value);
+
+        for (vle::value::Map::const_iterator it = map.begin();
+             it != map.end(); ++it) {
+            if (not it->second or not savable(*it->second)) {
+                return false;
+            }
+        }
+        return true;
+    }
+    default:
+        return false;
+    }
+}
+
+inline void saveValue(CheckpointWriter& out, const vle::value::Value& value)
+{
+    switch (value.getType()) {
+    case vle::value::Value::BOOLEAN:
+        out.write((boost::uint8_t)ATTRIBUTE_BOOLEAN);
+        out.write(vle::value::toBoolean(value));
+        break;
+    case vle::value::Value::INTEGER:
+        out.write((boost::uint8_t)ATTRIBUTE_INTEGER);
+        out.write((boost::int32_t)vle::value::toInteger(value));
+        break;
+    case vle::value::Value::DOUBLE:
+        out.write((boost::uint8_t)ATTRIBUTE_DOUBLE);
+        out.write(vle::value::toDouble(value));
+        break;
+    case vle::value::Value::STRING:
+        out.write((boost::uint8_t)ATTRIBUTE_STRING);
+        out.write(vle::value::toString(value));
+        break;
+    case vle::value::Value::SET:
+    {
+        const vle::value::Set& set = vle::value::toSetValue(value);
+
+        out.write((boost::uint8_t)ATTRIBUTE_SET);
+        out.write((boost::uint32_t)set.size());
+        for (vle::value::Set::const_iterator it = set.begin();
+             it != set.end(); ++it) {
+            saveValue(out, **it);
+        }
+        break;
+    }
+    case vle::value::Value::MAP:
+    {
+        const vle::value::Map& map = vle::value::toMapValue(value);
+
+        out.write((boost::uint8_t)ATTRIBUTE_MAP);
+        out.write((boost::uint32_t)map.size());
+        for (vle::value::Map::const_iterator it = map.begin();
+             it != map.end(); ++it) {
+            out.write(it->first);
+            saveValue(out, *it->second);
+        }
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+/**
+ * Read back a value written by saveValue(), whose kind tag is read.
+ */
+inline vle::value::Value* restoreValue(CheckpointReader& in,
+                                       boost::uint8_t kind)
+{
+    switch (kind) {
+    case ATTRIBUTE_BOOLEAN:
+        return vle::value::Boolean::create(in.get < boost::uint8_t >());
+    case ATTRIBUTE_INTEGER:
+        return vle::value::Integer::create(in.get < boost::int32_t >());
+    case ATTRIBUTE_DOUBLE:
+        return vle::value::Double::create(in.get < double >());
+    case ATTRIBUTE_STRING:
+        return vle::value::String::create(in.get < std::string >());
+    case ATTRIBUTE_SET:
+    {
+        vle::value::Set* set = vle::value::Set::create();
+
+        try {
+            boost::uint32_t n = in.get < boost::uint32_t >();
+
+            for (boost::uint32_t i = 0; i < n; ++i) {
+                set->add(restoreValue(in, in.get < boost::uint8_t >()));
+            }
+        } catch (...) {
+            delete set;
+            throw;
+        }
+        return set;
+    }
+    case ATTRIBUTE_MAP:
+    {
+        vle::value::Map* map = vle::value::Map::create();
+
+        try {
+            boost::uint32_t n = in.get < boost::uint32_t >();
+
+            for (boost::uint32_t i = 0; i < n; ++i) {
+                std::string name = in.get < std::string >();
+
+                map->add(name, restoreValue(in, in.get < boost::uint8_t >()));
+            }
+        } catch (...) {
+            delete map;
+            throw;
+        }
+        return map;
+    }
+    default:
+        in.error("bad value kind");
+        return 0;
+    }
+}
+
+/**
+ * Write event, its attributes that can be written; the others are
+ * reported to log at time.
+ */
+inline void saveEvent(CheckpointWriter& out,
+                      const vle::devs::ExternalEvent& event,
+                      const Logger& log, const vle::devs::Time& time)
+{
+    const vle::value::Map& attributes = event.getAttributes();
+    boost::uint32_t n = 0;
+
+    for (vle::value::Map::const_iterator it = attributes.begin();
+         it != attributes.end(); ++it) {
+        const vle::value::Value& value = *it->second;
+
+        if (dynamic_cast < const TransportPayload* >(&value) or
+            dynamic_cast < const ContainerPayload* >(&value) or
+            dynamic_cast < const ContainersPayload* >(&value) or
+            savable(value)) {
+            ++n;
+        } else {
+            LOGISTICS_ERROR(log, time, "CHECKPOINT: attribute " << it->first
+                            << " of an event on " << event.getPortName()
+                            << " dropped");
+        }
+    }
+    out.write(event.getPortName());
+    out.write(n);
+    for (vle::value::Map::const_iterator it = attributes.begin();
+         it != attributes.end(); ++it) {
+        const vle::value::Value& value = *it->second;
+
+        if (const TransportPayload* transport =
+            dynamic_cast < const TransportPayload* >(&value)) {
+            out.write(it->first);
+            out.write((boost::uint8_t)ATTRIBUTE_TRANSPORT);
+            transport->handle()->save(out);
+        } else if (const ContainerPayload* container =
+                   dynamic_cast < const ContainerPayload* >(&value)) {
+            out.write(it->first);
+            out.write((boost::uint8_t)ATTRIBUTE_CONTAINER);
+            container->handle()->save(out);
+        } else if (const ContainersPayload* containers =
+                   dynamic_cast < const ContainersPayload* >(&value)) {
+            out.write(it->first);
+            out.write((boost::uint8_t)ATTRIBUTE_CONTAINERS);
+            containers->handle()->save(out);
+        } else if (savable(value)) {
+            out.write(it->first);
+            saveValue(out, value);
+        }
+    }
+}
+
+inline vle::devs::ExternalEvent* restoreEvent(CheckpointReader& in,
+                                              Simulation& simulation)
+{
+    vle::devs::ExternalEvent* ee =
+        new vle::devs::ExternalEvent(in.get < std::string >());
+
+    try {
+        boost::uint32_t n = in.get < boost::uint32_t >();
+
+        for (boost::uint32_t i = 0; i < n; ++i) {
+            std::string name = in.get < std::string >();
+
+            boost::uint8_t kind = in.get < boost::uint8_t >();
+
+            switch (kind) {
+            case ATTRIBUTE_TRANSPORT:
+                ee->putAttribute(name, new TransportPayload(
+                                     TransportHandle(
+                                         new (simulation.transports())
+                                         Transport(in))));
+                break;
+            case ATTRIBUTE_CONTAINER:
+                ee->putAttribute(name, new ContainerPayload(
+                                     ContainerHandle(
+                                         new (simulation.containers())
+                                         Container(in))));
+                break;
+            case ATTRIBUTE_CONTAINERS:
+                ee->putAttribute(name, new ContainersPayload(
+                                     ContainersPayload::handle_type(
+                                         new SharedContainers(
+                                             in, simulation.containers()))));
+                break;
+            default:
+                ee->putAttribute(name, restoreValue(in, kind));
+            }
+        }
+    } catch (...) {
+        delete ee;
+        throw;
+    }
+    return ee;
+}
+
+} // namespace logistics
+
+#endif
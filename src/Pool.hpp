@@ -0,0 +1,205 @@
+/**
+ * @file Pool.hpp
+ * @author The VLE Development Team
+ * See the AUTHORS or Authors.txt file
+ */
+
+/*
+ * Copyright (C) 2012 ULCO http://www.univ-littoral.fr
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef POOL_HPP
+#define POOL_HPP 1
+
+#include <boost/noncopyable.hpp>
+#include <cstddef>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace logistics {
+
+/**
+ * Fixed-size object pool. Blocks are carved out of chunks and recycled
+ * through a free list; each block is preceded by a header that records
+ * its pool, so that a plain delete finds where to return it. A pool is
+ * meant to be used by the models of a single simulation, hence by a
+ * single thread, and is not locked.
+ */
+class ObjectPool : private boost::noncopyable
+{
+public:
+    ObjectPool(const std::string& name, std::size_t size,
+               std::size_t chunkSize = 1024) :
+        mName(name), mSize(align(size)), mChunkSize(chunkSize),
+        mFree(0), mCursor(0), mEnd(0), mOrphan(false), mAllocated(0),
+        mReused(0), mLive(0), mPeak(0)
+    { }
+
+    ~ObjectPool()
+    {
+        for (std::vector < char* >::const_iterator it = mChunks.begin();
+             it != mChunks.end(); ++it) {
+            delete[] *it;
+        }
+    }
+
+    /**
+     * Storage for an object of size bytes, from pool or, if pool is null
+     * or its blocks are too small, from the heap.
+     */
+    static void* allocate(ObjectPool* pool, std::size_t size)
+    {
+        Header* header;
+
+        if (pool and size <= pool->mSize) {
+            header = pool->take();
+        } else {
+            header = static_cast < Header* >(
+                ::operator new(sizeof(Header) + size));
+            header->pool = 0;
+        }
+        return header + 1;
+    }
+
+    static void deallocate(void* object)
+    {
+        if (object) {
+            Header* header = static_cast < Header* >(object) - 1;
+
+            if (header->pool) {
+                header->pool->give(header);
+            } else {
+                ::operator delete(header);
+            }
+        }
+    }
+
+    /**
+     * Called by the owner of the pool instead of delete: objects still
+     * alive, for instance in events the kernel has not freed yet, keep
+     * the pool until the last of them is deallocated.
+     */
+    void release()
+    {
+        if (mLive == 0) {
+            delete this;
+        } else {
+            mOrphan = true;
+        }
+    }
+
+    std::string statistics() const
+    {
+        std::ostringstream str;
+
+        str << mName << " pool: " << mAllocated << " allocations, "
+            << mReused << " reused, peak " << mPeak << " objects, "
+            << mChunks.size() << " chunks of " << mChunkSize << " x "
+            << mSize << " bytes";
+        return str.str();
+    }
+
+private:
+    union Header
+    {
+        ObjectPool* pool;
+        Header* next;
+        long double alignment;
+    };
+
+    static std::size_t align(std::size_t size)
+    {
+        return (size + sizeof(Header) - 1) / sizeof(Header) * sizeof(Header);
+    }
+
+    Header* take()
+    {
+        Header* header;
+
+        if (mFree) {
+            header = mFree;
+            mFree = mFree->next;
+            ++mReused;
+        } else {
+            if (mCursor == mEnd) {
+                std::size_t stride = sizeof(Header) + mSize;
+
+                mChunks.push_back(new char[stride * mChunkSize]);
+                mCursor = mChunks.back();
+                mEnd = mCursor + stride * mChunkSize;
+            }
+            header = reinterpret_cast < Header* >(mCursor);
+            mCursor += sizeof(Header) + mSize;
+        }
+        header->pool = this;
+        ++mAllocated;
+        if (++mLive > mPeak) {
+            mPeak = mLive;
+        }
+        return header;
+    }
+
+    void give(Header* header)
+    {
+        header->next = mFree;
+        mFree = header;
+        if (--mLive == 0 and mOrphan) {
+            delete this;
+        }
+    }
+
+    std::string mName;
+    std::size_t mSize;
+    std::size_t mChunkSize;
+    std::vector < char* > mChunks;
+    Header* mFree;
+    char* mCursor;
+    char* mEnd;
+    bool mOrphan;
+
+    // statistics
+    unsigned long mAllocated;
+    unsigned long mReused;
+    unsigned long mLive;
+    unsigned long mPeak;
+};
+
+/**
+ * Base of the classes whose objects can be created in an ObjectPool with
+ * new (pool) T(...). A plain new still allocates on the heap, and delete
+ * returns either kind of object to where it came from.
+ */
+class Pooled
+{
+public:
+    static void* operator new(std::size_t size)
+    { return ObjectPool::allocate(0, size); }
+
+    static void* operator new(std::size_t size, ObjectPool& pool)
+    { return ObjectPool::allocate(&pool, size); }
+
+    static void operator delete(void* object)
+    { ObjectPool::deallocate(object); }
+
+    static void operator delete(void* object, ObjectPool& /* pool */)
+    { ObjectPool::deallocate(object); }
+};
+
+} // namespace logistics
+
+#endif
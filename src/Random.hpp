@@ -0,0 +1,153 @@
+/**
+ * @file Random.hpp
+ * @author The VLE Development Team
+ * See the AUTHORS or Authors.txt file
+ */
+
+/*
+ * Copyright (C) 2012 ULCO http://www.univ-littoral.fr
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef RANDOM_HPP
+#define RANDOM_HPP 1
+
+#include <Checkpoint.hpp>
+#include <boost/cstdint.hpp>
+
+namespace logistics {
+
+/**
+ * Uniform draws served from blocks of BLOCK values in [0, 1), which a
+ * xorshift128+ generator refills in one tight loop. The stream is fully
+ * determined by its seed; models seed it from their vle::utils::Rand,
+ * so that a simulation stays reproducible for a given experiment seed.
+ */
+class RandomStream
+{
+public:
+    RandomStream() :
+        mNext(BLOCK)
+    { seed(0); }
+
+    void seed(boost::uint64_t value)
+    {
+        // splitmix64 spreads any seed, 0 included, over the whole state
+        mState[0] = mix(value);
+        mState[1] = mix(value);
+        mNext = BLOCK;
+    }
+
+    /**
+     * Uniform in [0, 1).
+     */
+    double uniform()
+    {
+        if (mNext == BLOCK) {
+            refill();
+        }
+        return mBlock[mNext++];
+    }
+
+    /**
+     * Uniform in [min, max); min when the range is empty.
+     */
+    double getDouble(double min, double max)
+    {
+        double u = uniform();
+
+        return min < max ? min + (max - min) * u : min;
+    }
+
+    /**
+     * Uniform integer in [min, max], as vle::utils::Rand::getInt.
+     */
+    int getInt(int min, int max)
+    {
+        double u = uniform();
+
+        return min < max ? min + (int)(u * ((double)max - min + 1)) : min;
+    }
+
+    bool getBool()
+    { return uniform() < .5; }
+
+    /**
+     * The generator state and the draws left in the current block: a
+     * restored stream goes on with the same values.
+     */
+    void save(CheckpointWriter& out) const
+    {
+        out.write(mState[0]);
+        out.write(mState[1]);
+        out.write((boost::uint16_t)mNext);
+        for (int i = mNext; i < BLOCK; ++i) {
+            out.write(mBlock[i]);
+        }
+    }
+
+    void restore(CheckpointReader& in)
+    {
+        in.read(mState[0]);
+        in.read(mState[1]);
+        mNext = in.get < boost::uint16_t >();
+        if (mNext > BLOCK) {
+            in.error("bad random stream");
+        }
+        for (int i = mNext; i < BLOCK; ++i) {
+            in.read(mBlock[i]);
+        }
+    }
+
+private:
+    enum { BLOCK = 256 };
+
+    boost::uint64_t mix(boost::uint64_t& x)
+    {
+        boost::uint64_t z = (x += 0x9e3779b97f4a7c15ULL);
+
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        return z ^ (z >> 31);
+    }
+
+    void refill()
+    {
+        boost::uint64_t s0 = mState[0];
+        boost::uint64_t s1 = mState[1];
+
+        for (int i = 0; i < BLOCK; ++i) {
+            boost::uint64_t x = s0;
+            boost::uint64_t y = s1;
+
+            s0 = y;
+            x ^= x << 23;
+            s1 = x ^ y ^ (x >> 17) ^ (y >> 26);
+            // the 53 high bits of the sum make the mantissa of a double
+            mBlock[i] = ((s1 + y) >> 11) * (1. / 9007199254740992.);
+        }
+        mState[0] = s0;
+        mState[1] = s1;
+        mNext = 0;
+    }
+
+    boost::uint64_t mState[2];
+    double mBlock[BLOCK];
+    int mNext;
+};
+
+} // namespace logistics
+
+#endif
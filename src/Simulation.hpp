@@ -0,0 +1,254 @@
+/**
+ * @file Simulation.hpp
+ * @author The VLE Development Team
+ * See the AUTHORS or Authors.txt file
+ */
+
+/*
+ * Copyright (C) 2012 ULCO http://www.univ-littoral.fr
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SIMULATION_HPP
+#define SIMULATION_HPP 1
+
+#include <vle/devs/InitEventList.hpp>
+#include <vle/graph/Model.hpp>
+#include <Checkpoint.hpp>
+#include <Container.hpp>
+#include <Log.hpp>
+#include <Pool.hpp>
+#include <Transport.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+#include <cstdlib>
+#include <map>
+#include <sstream>
+
+namespace logistics {
+
+/**
+ * State shared by the models of one simulation. A context is found from
+ * the root of the model graph, which each running simulation owns, and
+ * is reference counted by the dynamics: each of them acquires it in its
+ * constructor and releases it in its destructor. Simulations running in
+ * the same process, on one thread or several, thus have their own pools
+ * and identifier sequences; within a simulation, the models are run by a
+ * single thread and the context is not locked. The last release, at
+ * the end of the run, reports the pool statistics and the number of
+ * external events the models received, and waits for the log to be
+ * written.
+ *
+ * A simulation can also be checkpointed and resumed. The "checkpoint"
+ * condition of any of its models, or else the LOGISTICS_CHECKPOINT
+ * environment variable, names the file where the state of every model
+ * is saved at the end of the run, with the date of its last transition.
+ * The "restore" condition, or else LOGISTICS_RESTORE, names a checkpoint
+ * that the models load in init() instead of starting empty; the
+ * experiment then begins at the date of the checkpoint, which the log
+ * gives when it is written.
+ */
+class Simulation : private boost::noncopyable
+{
+public:
+    static Simulation& acquire(const vle::graph::Model& model,
+                               const vle::devs::InitEventList& events)
+    {
+        const vle::graph::Model* root = &model;
+
+        while (root->getParent()) {
+            root = root->getParent();
+        }
+
+        boost::mutex::scoped_lock lock(mutex());
+        Registry::iterator it = registry().find(root);
+
+        if (it == registry().end()) {
+            it = registry().insert(
+                std::make_pair(root, new Simulation(root))).first;
+        }
+        if (events.exist("checkpoint")) {
+            it->second->mCheckpointPath =
+                vle::value::toString(events.get("checkpoint"));
+        }
+        if (events.exist("restore")) {
+            it->second->mRestorePath =
+                vle::value::toString(events.get("restore"));
+        }
+        ++it->second->mReferences;
+        return *it->second;
+    }
+
+    static void release(Simulation& simulation)
+    {
+        boost::mutex::scoped_lock lock(mutex());
+
+        if (--simulation.mReferences == 0) {
+            registry().erase(simulation.mRoot);
+            delete &simulation;
+        }
+    }
+
+    ObjectPool& containers()
+    { return *mContainers; }
+
+    ContainerID newContainerID()
+    { return mContainerID++; }
+
+    TransportID newTransportID()
+    { return mTransportID++; }
+
+    ObjectPool& transports()
+    { return *mTransports; }
+
+    /**
+     * Count the events of an external transition.
+     */
+    void received(std::size_t events)
+    { mEvents += events; }
+
+    /**
+     * Date of the transition being run, that of the checkpoint if it is
+     * the last.
+     */
+    void transition(const vle::devs::Time& time)
+    { mDate = time.getValue(); }
+
+    double date() const
+    { return mDate; }
+
+    /**
+     * The checkpoint the models fill in finish(), or null if the run is
+     * not checkpointed.
+     */
+    Checkpoint* checkpoint()
+    {
+        if (not mCheckpoint and not mCheckpointPath.empty()) {
+            mCheckpoint.reset(new Checkpoint);
+        }
+        return mCheckpoint.get();
+    }
+
+    /**
+     * The checkpoint the models restore in init(), at the begin date
+     * time, or null if the run starts empty. It is read by the first
+     * call, which also resumes the identifier sequences. The run must
+     * begin at the date of the checkpoint: the models count their
+     * delays from there.
+     */
+    const Checkpoint* restored(const vle::devs::Time& time)
+    {
+        if (not mRestored and not mRestorePath.empty()) {
+            mRestored.reset(new Checkpoint(mRestorePath));
+            mContainerID = mRestored->containerID();
+            mTransportID = mRestored->transportID();
+        }
+        if (mRestored and mRestored->date() != time.getValue()) {
+            std::ostringstream message;
+
+            message.precision(17);
+            message << "taken at " << mRestored->date()
+                    << ", the run begins at " << time.getValue();
+            mRestored->error(message.str());
+        }
+        mDate = time.getValue();
+        return mRestored.get();
+    }
+
+private:
+    typedef std::map < const vle::graph::Model*, Simulation* > Registry;
+
+    Simulation(const vle::graph::Model* root) :
+        mRoot(root), mName(root->getName()), mReferences(0),
+        mContainers(new ObjectPool("containers", sizeof(Container))),
+        mTransports(new ObjectPool("transports", sizeof(Transport))),
+        mContainerID(0), mTransportID(0), mEvents(0), mDate(0)
+    {
+        const char* checkpoint = std::getenv("LOGISTICS_CHECKPOINT");
+        const char* restore = std::getenv("LOGISTICS_RESTORE");
+
+        if (checkpoint) {
+            mCheckpointPath = checkpoint;
+        }
+        if (restore) {
+            mRestorePath = restore;
+        }
+    }
+
+    ~Simulation()
+    {
+        std::ostringstream events;
+        std::string line;
+
+        line = "[" + mName + "] " + mContainers->statistics() + "\n";
+        LogSink::instance().write(line);
+        line = "[" + mName + "] " + mTransports->statistics() + "\n";
+        LogSink::instance().write(line);
+        events << "[" << mName << "] " << mEvents << " events received\n";
+        line = events.str();
+        LogSink::instance().write(line);
+        if (mCheckpoint) {
+            try {
+                std::ostringstream written;
+
+                mCheckpoint->sequences(mContainerID, mTransportID);
+                mCheckpoint->date(mDate);
+                mCheckpoint->save(mCheckpointPath);
+                written.precision(17);
+                written << "[" << mName << "] checkpoint written to "
+                        << mCheckpointPath << " at " << mDate << "\n";
+                line = written.str();
+            } catch (const std::exception& e) {
+                line = "[" + mName + "] " + e.what() + "\n";
+            }
+            LogSink::instance().write(line);
+        }
+        LogSink::instance().flush();
+        mContainers->release();
+        mTransports->release();
+    }
+
+    static Registry& registry()
+    {
+        static Registry registry;
+
+        return registry;
+    }
+
+    static boost::mutex& mutex()
+    {
+        static boost::mutex mutex;
+
+        return mutex;
+    }
+
+    const vle::graph::Model* mRoot;
+    std::string mName;
+    unsigned int mReferences;
+    ObjectPool* mContainers;
+    ObjectPool* mTransports;
+    ContainerID mContainerID;
+    TransportID mTransportID;
+    unsigned long mEvents;
+    double mDate;
+    std::string mCheckpointPath;
+    std::string mRestorePath;
+    boost::scoped_ptr < Checkpoint > mCheckpoint;
+    boost::scoped_ptr < Checkpoint > mRestored;
+};
+
+} // namespace logistics
+
+#endif
@@ -22,38 +22,110 @@
  */
 
 #include <vle/devs/Dynamics.hpp>
-#include <Container.hpp>
+#include <Payload.hpp>
 
 namespace logistics {
 
+/**
+ * Unloading quay: sends each container of the manifests it receives on
+ * its own. With the Batch condition set, the containers of one step are
+ * sent instead as one manifest per content type, with the type, which
+ * Dispatch and Transit take in as so many single containers.
+ */
 class Split : public vle::devs::Dynamics
 {
 public:
     Split(const vle::devs::DynamicsInit& init,
           const vle::devs::InitEventList& events) :
-        vle::devs::Dynamics(init, events)
+        vle::devs::Dynamics(init, events),
+        mSimulation(Simulation::acquire(getModel(), events)),
+        mLog(getModelName(), events),
+        mBatch(events.exist("Batch") and
+               vle::value::toBoolean(events.get("Batch")))
     {
     }
 
-    vle::devs::Time init(const vle::devs::Time& /* time */)
+    virtual ~Split()
     {
-        return vle::devs::Time::infinity;
+        Simulation::release(mSimulation);
+    }
+
+    vle::devs::Time init(const vle::devs::Time& time)
+    {
+        mPhase = IDLE;
+        if (const Checkpoint* checkpoint = mSimulation.restored(time)) {
+            CheckpointReader in(*checkpoint, getModel());
+            boost::uint32_t n;
+
+            mPhase = (phase)in.get < boost::uint8_t >();
+            in.read(n);
+            for (boost::uint32_t i = 0; i < n; ++i) {
+                mContainersList.push_back(
+                    ContainersPayload::handle_type(
+                        new SharedContainers(in, mSimulation.containers())));
+            }
+        }
+        return timeAdvance();
+    }
+
+    void finish()
+    {
+        if (Checkpoint* checkpoint = mSimulation.checkpoint()) {
+            CheckpointWriter out(*checkpoint, getModel());
+
+            out.write((boost::uint8_t)mPhase);
+            out.write((boost::uint32_t)mContainersList.size());
+            for (ContainersList::const_iterator it =
+                     mContainersList.begin(); it != mContainersList.end();
+                 ++it) {
+                (*it)->save(out);
+            }
+        }
     }
 
     void output(const vle::devs::Time& /* time */,
                 vle::devs::ExternalEventList& output) const
     {
-        if (mPhase == SEND) {
-            for (std::vector < Containers* >::const_iterator it =
+        if (mPhase == SEND and mBatch) {
+            boost::shared_ptr < SharedContainers > batches[2];
+
+            for (ContainersList::const_iterator it =
+                     mContainersList.begin(); it != mContainersList.end();
+                 ++it) {
+                for (SharedContainers::const_iterator itc = (*it)->begin();
+                     itc != (*it)->end(); ++itc) {
+                    boost::shared_ptr < SharedContainers >& batch =
+                        batches[(*itc)->type()];
+
+                    if (not batch) {
+                        batch.reset(new SharedContainers);
+                    }
+                    batch->push_back(*itc);
+                }
+            }
+            for (int type = FOOD; type <= NOFOOD; ++type) {
+                if (batches[type]) {
+                    vle::devs::ExternalEvent* ee =
+                        new vle::devs::ExternalEvent("out");
+
+                    ee << vle::devs::attribute("containers",
+                                               new ContainersPayload(
+                                                   batches[type]));
+                    ee << vle::devs::attribute("type", type);
+                    output.addEvent(ee);
+                }
+            }
+        } else if (mPhase == SEND) {
+            for (ContainersList::const_iterator it =
                      mContainersList.begin(); it != mContainersList.end();
                  ++it) {
-                for (Containers::const_iterator itc = (*it)->begin();
+                for (SharedContainers::const_iterator itc = (*it)->begin();
                      itc != (*it)->end(); ++itc) {
                     vle::devs::ExternalEvent* ee =
                         new vle::devs::ExternalEvent("out");
 
                     ee << vle::devs::attribute("container",
-                                               (*itc)->toValue());
+                                               new ContainerPayload(*itc));
                     output.addEvent(ee);
                 }
             }
@@ -69,8 +141,9 @@ public:
         }
     }
 
-    void internalTransition(const vle::devs::Time& /* time */)
+    void internalTransition(const vle::devs::Time& time)
     {
+        mSimulation.transition(time);
         mContainersList.clear();
         mPhase = IDLE;
     }
@@ -80,15 +153,16 @@ public:
     {
         vle::devs::ExternalEventList::const_iterator it = events.begin();
 
+        mSimulation.received(events.size());
+        mSimulation.transition(time);
+
         while (it != events.end()) {
-            Containers* containers = new Containers(
-                vle::value::toSetValue(
-                    (*it)->getAttributeValue("containers")));
+            ContainersPayload::handle_type containers =
+                toContainers((*it)->getAttributeValue("containers"),
+                             mSimulation);
 
-            std::cout << time << " - [" << getModelName()
-                      << "] SPLIT: " << containers->toString() << std::endl;
+            LOGISTICS_INFO(mLog, time, "SPLIT: " << containers->toString());
 
-            containers->arrived(time);
             mContainersList.push_back(containers);
             ++it;
         }
@@ -98,9 +172,15 @@ public:
 private:
     enum phase { IDLE, SEND };
 
+    typedef std::vector < ContainersPayload::handle_type > ContainersList;
+
+    Simulation& mSimulation;
+    Logger mLog;
+    bool mBatch;
+
     // state
     phase mPhase;
-    std::vector < Containers* > mContainersList;
+    ContainersList mContainersList;
 };
 
 } // namespace logistics
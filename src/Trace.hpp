@@ -0,0 +1,351 @@
+/**
+ * @file Trace.hpp
+ * @author The VLE Development Team
+ * See the AUTHORS or Authors.txt file
+ */
+
+/*
+ * Copyright (C) 2012 ULCO http://www.univ-littoral.fr
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TRACE_HPP
+#define TRACE_HPP 1
+
+#include <vle/utils/Exception.hpp>
+#include <Transport.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/static_assert.hpp>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+#ifdef __unix__
+#include <sys/mman.h>
+#endif
+
+namespace logistics {
+
+/*
+ * Binary arrival trace, in the byte order of the machine that wrote it:
+ *
+ *   TraceHeader
+ *   for each transport, by nondecreasing arrival date:
+ *     TraceTransport, followed by its TraceContainer records
+ *   the location names, NUL-terminated, at offset TraceHeader::names
+ *
+ * Locations are stored as indexes in the name table, which the reader
+ * interns when it opens the trace. The identifiers are those of the run
+ * the trace was taken from; a replay gives new ones (see
+ * TransportGenerator.cpp). All records are 8-byte multiples, so that
+ * they can be read in place from the mapping.
+ */
+
+struct TraceHeader
+{
+    char magic[8];
+    boost::uint32_t version;
+    boost::uint32_t locations;
+    boost::uint64_t transports;
+    boost::uint64_t containers;
+    boost::uint64_t names;
+};
+
+struct TraceTransport
+{
+    double arrival;
+    double departure;
+    boost::uint32_t id;
+    boost::uint32_t capacity;
+    boost::uint32_t destination;
+    boost::uint16_t containers;
+    boost::uint8_t type;
+    boost::uint8_t content;
+};
+
+struct TraceContainer
+{
+    double exigibility;
+    boost::uint32_t id;
+    boost::uint32_t source;
+    boost::uint32_t destination;
+    boost::uint8_t content;
+    boost::uint8_t padding[3];
+};
+
+BOOST_STATIC_ASSERT(sizeof(TraceHeader) == 40);
+BOOST_STATIC_ASSERT(sizeof(TraceTransport) == 32);
+BOOST_STATIC_ASSERT(sizeof(TraceContainer) == 24);
+
+static const char TRACE_MAGIC[8] = { 'L', 'O', 'G', 'T', 'R', 'A', 'C', 'E' };
+static const boost::uint32_t TRACE_VERSION = 1;
+
+/**
+ * Sequential reader of a trace file. The file is memory mapped and read
+ * in place, one transport and its containers at a time; the pages left
+ * behind are handed back to the system every WINDOW bytes, so that the
+ * memory used does not grow with the length of the trace.
+ */
+class TraceReader : private boost::noncopyable
+{
+public:
+    TraceReader(const std::string& path) :
+        mPath(path)
+    {
+        try {
+            mFile.open(path);
+        } catch (const std::exception& e) {
+            throw vle::utils::ModellingError(
+                "trace " + path + ": " + e.what());
+        }
+        if (mFile.size() < sizeof(TraceHeader)) {
+            error("truncated header");
+        }
+
+        const TraceHeader* header =
+            reinterpret_cast < const TraceHeader* >(mFile.data());
+
+        if (std::memcmp(header->magic, TRACE_MAGIC, sizeof(TRACE_MAGIC)) or
+            header->version != TRACE_VERSION) {
+            error("not a version 1 trace");
+        }
+        if (header->names < sizeof(TraceHeader) or
+            header->names > mFile.size()) {
+            error("bad name table offset");
+        }
+
+        const char* name = mFile.data() + header->names;
+        const char* end = mFile.data() + mFile.size();
+
+        for (boost::uint32_t i = 0; i < header->locations; ++i) {
+            const char* last = static_cast < const char* >(
+                std::memchr(name, '\0', end - name));
+
+            if (not last) {
+                error("truncated name table");
+            }
+            mLocations.push_back(Locations::id(std::string(name, last)));
+            name = last + 1;
+        }
+
+        mCursor = mFile.data() + sizeof(TraceHeader);
+        mEnd = mFile.data() + header->names;
+        mReleased = mFile.data();
+        check();
+#ifdef __unix__
+        ::madvise(const_cast < char* >(mFile.data()), mFile.size(),
+                  MADV_SEQUENTIAL);
+#endif
+    }
+
+    bool empty() const
+    { return mCursor == mEnd; }
+
+    /**
+     * The current transport; the trace must not be empty.
+     */
+    const TraceTransport& transport() const
+    { return *reinterpret_cast < const TraceTransport* >(mCursor); }
+
+    /**
+     * The transport().containers records of the current transport.
+     */
+    const TraceContainer* containers() const
+    {
+        return reinterpret_cast < const TraceContainer* >(
+            mCursor + sizeof(TraceTransport));
+    }
+
+    LocationID location(boost::uint32_t index) const
+    {
+        if (index >= mLocations.size()) {
+            error("bad location index");
+        }
+        return mLocations[index];
+    }
+
+    /**
+     * Position of the current transport in the file.
+     */
+    boost::uint64_t offset() const
+    { return mCursor - mFile.data(); }
+
+    /**
+     * Move to the transport at offset, a position given by offset().
+     */
+    void seek(boost::uint64_t offset)
+    {
+        if (offset < sizeof(TraceHeader) or
+            offset > (boost::uint64_t)(mEnd - mFile.data())) {
+            error("bad offset");
+        }
+        mCursor = mFile.data() + offset;
+        check();
+    }
+
+    /**
+     * Move to the next transport.
+     */
+    void next()
+    {
+        mCursor += size();
+        check();
+#ifdef __unix__
+        if (mCursor - mReleased >= WINDOW) {
+            std::size_t length = (mCursor - mReleased) / WINDOW * WINDOW;
+
+            ::madvise(const_cast < char* >(mReleased), length,
+                      MADV_DONTNEED);
+            mReleased += length;
+        }
+#endif
+    }
+
+private:
+    // a multiple of the page size of every system
+    static const std::ptrdiff_t WINDOW = 1 << 20;
+
+    std::size_t size() const
+    {
+        return sizeof(TraceTransport) +
+            transport().containers * sizeof(TraceContainer);
+    }
+
+    void check() const
+    {
+        if (empty()) {
+            return;
+        }
+        if (mEnd - mCursor < (std::ptrdiff_t)sizeof(TraceTransport) or
+            mEnd - mCursor < (std::ptrdiff_t)size()) {
+            error("truncated record");
+        }
+        if (transport().type > TRAIN or transport().content > NOFOOD) {
+            error("bad transport record");
+        }
+        for (boost::uint16_t i = 0; i < transport().containers; ++i) {
+            if (containers()[i].content > NOFOOD) {
+                error("bad container record");
+            }
+        }
+    }
+
+    void error(const std::string& message) const
+    {
+        throw vle::utils::ModellingError("trace " + mPath + ": " + message);
+    }
+
+    std::string mPath;
+    boost::iostreams::mapped_file_source mFile;
+    std::vector < LocationID > mLocations;
+    const char* mCursor;
+    const char* mEnd;
+    const char* mReleased;
+};
+
+/**
+ * Writer of a trace file, for the converters: transports are appended
+ * with their containers in arrival order, and close() writes the name
+ * table and the header.
+ */
+class TraceWriter : private boost::noncopyable
+{
+public:
+    TraceWriter(const std::string& path) :
+        mPath(path), mFile(path.c_str(), std::ios::out | std::ios::binary |
+                           std::ios::trunc),
+        mArrival(-1e300)
+    {
+        std::memset(&mHeader, 0, sizeof(TraceHeader));
+        std::memcpy(mHeader.magic, TRACE_MAGIC, sizeof(TRACE_MAGIC));
+        mHeader.version = TRACE_VERSION;
+        write(&mHeader, sizeof(TraceHeader));
+    }
+
+    /**
+     * Index of name in the name table.
+     */
+    boost::uint32_t location(const std::string& name)
+    {
+        std::map < std::string, boost::uint32_t >::const_iterator it =
+            mIndex.find(name);
+
+        if (it != mIndex.end()) {
+            return it->second;
+        }
+        mNames.push_back(name);
+        return mIndex[name] = mNames.size() - 1;
+    }
+
+    void add(TraceTransport transport,
+             const std::vector < TraceContainer >& containers)
+    {
+        if (transport.arrival < mArrival) {
+            throw vle::utils::ArgError(
+                "trace " + mPath + ": transports out of arrival order");
+        }
+        if (containers.size() > 0xffff) {
+            throw vle::utils::ArgError(
+                "trace " + mPath + ": too many containers in a transport");
+        }
+        mArrival = transport.arrival;
+        transport.containers = containers.size();
+        write(&transport, sizeof(TraceTransport));
+        if (not containers.empty()) {
+            write(&containers[0], containers.size() * sizeof(TraceContainer));
+        }
+        ++mHeader.transports;
+        mHeader.containers += containers.size();
+    }
+
+    void close()
+    {
+        mHeader.names = mFile.tellp();
+        mHeader.locations = mNames.size();
+        for (std::vector < std::string >::const_iterator it = mNames.begin();
+             it != mNames.end(); ++it) {
+            write(it->c_str(), it->size() + 1);
+        }
+        mFile.seekp(0);
+        write(&mHeader, sizeof(TraceHeader));
+        mFile.close();
+    }
+
+    const TraceHeader& header() const
+    { return mHeader; }
+
+private:
+    void write(const void* data, std::size_t size)
+    {
+        if (not mFile.write(static_cast < const char* >(data), size)) {
+            throw vle::utils::FileError("trace " + mPath + ": write error");
+        }
+    }
+
+    std::string mPath;
+    std::ofstream mFile;
+    TraceHeader mHeader;
+    double mArrival;
+    std::vector < std::string > mNames;
+    std::map < std::string, boost::uint32_t > mIndex;
+};
+
+} // namespace logistics
+
+#endif
@@ -22,18 +22,31 @@
  */
 
 #include <vle/devs/Dynamics.hpp>
-#include <Container.hpp>
-#include <Transport.hpp>
+#include <Loading.hpp>
+#include <Payload.hpp>
 
 namespace logistics {
 
+/**
+ * Transit zone: containers wait until a transport takes them. The
+ * containers loaded are chosen by the Loading policy (see Loading.hpp),
+ * each policy being registered as its own dynamics below.
+ */
+template < class Loading >
 class Transit : public vle::devs::Dynamics
 {
 public:
     Transit(const vle::devs::DynamicsInit& init,
             const vle::devs::InitEventList& events) :
-        vle::devs::Dynamics(init, events)
+        vle::devs::Dynamics(init, events),
+        mSimulation(Simulation::acquire(getModel(), events)),
+        mLog(getModelName(), events)
+    {
+    }
+
+    virtual ~Transit()
     {
+        Simulation::release(mSimulation);
     }
 
     void removeReadyTransports()
@@ -41,71 +54,42 @@ public:
         ReadyTransports::iterator it = mReadyTransports.begin();
 
         while (it != mReadyTransports.end()) {
-            {
-                LoadingTransports::iterator itc = mLoadingTransports.find(*it);
-                const Containers& containers = itc->second;
-                Containers::const_iterator itcc = containers.begin();
-
-                while (itcc != containers.end()) {
-                    removeSelectedContainer(*itcc);
-                    ++itcc;
-                }
-                mLoadingTransports.erase(itc);
-            }
-            {
-                bool found = false;
-                OrderedTransportList::iterator itc = mWaitingTransports.begin();
-
-                while (not found and itc != mWaitingTransports.end()) {
-                    if ((*itc)->id() == *it) {
-                        mWaitingTransports.erase(itc);
-                        found = true;
-                    } else {
-                        ++itc;
-                    }
-                }
-            }
+            // the loaded containers left the waiting index when they were
+            // loaded; they are released with their transport entry, or
+            // later if an out event still shares them
+            mLoadingTransports.erase(*it);
+            delete mWaitingTransports.erase(*it);
             ++it;
         }
         mReadyTransports.clear();
     }
 
-    void removeSelectedContainer(Container* container)
+    void addContainer(const Container& arrived,
+                      const vle::devs::Time& time)
     {
-        bool found = false;
-        Containers::iterator it = mWaitingContainers.begin();
+        Container* container =
+            new (mSimulation.containers()) Container(arrived);
 
-        while (not found and it != mWaitingContainers.end()) {
-            if ((*it) == container) {
-                found = true;
-            } else {
-                ++it;
-            }
-        }
-        if (found) {
-            delete *it;
-            mWaitingContainers.erase(it);
-        }
+        LOGISTICS_INFO(mLog, time, "TRANSIT CONTAINER: "
+                       << container->toString());
+
+        container->arrived(time);
+        mWaitingContainers.add(container);
+        mLoading.add(container, mWaitingContainers.rank(container));
     }
 
     void loadContainer(Transport* transport)
     {
-        vle::devs::Time time = vle::devs::Time::infinity;
-        Containers::iterator it = mWaitingContainers.begin();
-        Containers::iterator itc;
-        Container* selectedContainer = 0;
-
-        while (it != mWaitingContainers.end()) {
-            if ((*it)->exigibilityDate() < time) {
-                time = (*it)->exigibilityDate();
-                itc = it;
-                selectedContainer = *it;
-            }
-            ++it;
-        }
-        if (selectedContainer != 0) {
-            mLoadingTransports[transport->id()].push_back(selectedContainer);
-            mWaitingContainers.erase(itc);
+        if (not mWaitingContainers.empty()) {
+            Container* selectedContainer =
+                mLoading.select(mWaitingContainers, *transport);
+
+            mLoading.remove(selectedContainer,
+                            mWaitingContainers.rank(selectedContainer));
+            mWaitingContainers.remove(selectedContainer);
+
+            mLoadingTransports[transport->id()].push_back(
+                ContainerHandle(selectedContainer));
         }
     }
 
@@ -121,7 +105,7 @@ public:
                 mLoadingTransports.find((*it)->id());
 
             if (itt == mLoadingTransports.end()) {
-                mLoadingTransports[(*it)->id()] = Containers();
+                mLoadingTransports[(*it)->id()] = SharedContainers();
                 itt = mLoadingTransports.find((*it)->id());
             }
             if ((int)itt->second.size() < (*it)->capacity()) {
@@ -137,9 +121,59 @@ public:
 
 /*  - - - - - - - - - - - - - --ooOoo-- - - - - - - - - - - -  */
 
-    vle::devs::Time init(const vle::devs::Time& /* time */)
+    vle::devs::Time init(const vle::devs::Time& time)
     {
-        return vle::devs::Time::infinity;
+        mPhase = IDLE;
+        if (const Checkpoint* checkpoint = mSimulation.restored(time)) {
+            CheckpointReader in(*checkpoint, getModel());
+            boost::uint32_t n;
+
+            mPhase = (phase)in.get < boost::uint8_t >();
+            mWaitingContainers.restore(in, mSimulation.containers());
+            for (ContainerSlot i = 0; i < mWaitingContainers.size(); ++i) {
+                Container* container = mWaitingContainers.container(i);
+
+                mLoading.add(container, mWaitingContainers.rank(container));
+            }
+            mWaitingTransports.restore(in, mSimulation.transports());
+            in.read(n);
+            for (boost::uint32_t i = 0; i < n; ++i) {
+                TransportID id = in.get < boost::uint32_t >();
+
+                mLoadingTransports[id] =
+                    SharedContainers(in, mSimulation.containers());
+            }
+            in.read(n);
+            mReadyTransports.resize(n);
+            for (boost::uint32_t i = 0; i < n; ++i) {
+                mReadyTransports[i] = in.get < boost::uint32_t >();
+            }
+        }
+        return timeAdvance();
+    }
+
+    void finish()
+    {
+        if (Checkpoint* checkpoint = mSimulation.checkpoint()) {
+            CheckpointWriter out(*checkpoint, getModel());
+
+            out.write((boost::uint8_t)mPhase);
+            mWaitingContainers.save(out);
+            mWaitingTransports.save(out);
+            out.write((boost::uint32_t)mLoadingTransports.size());
+            for (LoadingTransports::const_iterator it =
+                     mLoadingTransports.begin();
+                 it != mLoadingTransports.end(); ++it) {
+                out.write((boost::uint32_t)it->first);
+                it->second.save(out);
+            }
+            out.write((boost::uint32_t)mReadyTransports.size());
+            for (ReadyTransports::const_iterator it =
+                     mReadyTransports.begin();
+                 it != mReadyTransports.end(); ++it) {
+                out.write((boost::uint32_t)*it);
+            }
+        }
     }
 
     void output(const vle::devs::Time& time,
@@ -148,9 +182,12 @@ public:
         if (mPhase == LOADED) {
             OrderedTransportList::const_iterator it =
                 mWaitingTransports.begin();
+            boost::scoped_ptr < LogRecord > record(
+                mLog.enabled(LEVEL_INFO) ? new LogRecord(mLog, time) : 0);
 
-            std::cout << time << " - [" << getModelName()
-                      << "] TRANSIT LOADED: ";
+            if (record) {
+                record->stream() << "TRANSIT LOADED: ";
+            }
 
             while (it != mWaitingTransports.end()) {
                 LoadingTransports::const_iterator itt =
@@ -161,21 +198,22 @@ public:
                     vle::devs::ExternalEvent* ee =
                         new vle::devs::ExternalEvent("loaded");
 
-                    std::cout << (*it)->id() << " ";
-
+                    if (record) {
+                        record->stream() << (*it)->id() << " ";
+                    }
                     ee << vle::devs::attribute("id", (int)(*it)->id());
                     output.addEvent(ee);
                 }
                 ++it;
             }
-
-            std::cout << std::endl;
-
         } else if (mPhase == OUT) {
             ReadyTransports::const_iterator it = mReadyTransports.begin();
+            boost::scoped_ptr < LogRecord > record(
+                mLog.enabled(LEVEL_INFO) ? new LogRecord(mLog, time) : 0);
 
-            std::cout << time << " - [" << getModelName()
-                      << "] TRANSIT OUT: { ";
+            if (record) {
+                record->stream() << "TRANSIT OUT: { ";
+            }
 
             while (it != mReadyTransports.end()) {
                 vle::devs::ExternalEvent* ee =
@@ -184,16 +222,23 @@ public:
                     mLoadingTransports.find(*it);
                 Transport* transport = mWaitingTransports.find(*it);
 
-                std::cout << *it << " ";
-
-                ee << vle::devs::attribute("transport", transport->toValue());
-                ee << vle::devs::attribute("containers", itc->second.toValue());
+                if (record) {
+                    record->stream() << *it << " ";
+                }
+                ee << vle::devs::attribute(
+                    "transport", new TransportPayload(
+                        TransportHandle(new (mSimulation.transports())
+                                        Transport(*transport))));
+                ee << vle::devs::attribute(
+                    "containers", new ContainersPayload(
+                        ContainersPayload::handle_type(
+                            new SharedContainers(itc->second))));
                 output.addEvent(ee);
                 ++it;
             }
-
-            std::cout << "}" << std::endl;
-
+            if (record) {
+                record->stream() << "}";
+            }
         }
     }
 
@@ -206,8 +251,9 @@ public:
         }
     }
 
-    void internalTransition(const vle::devs::Time& /* time */)
+    void internalTransition(const vle::devs::Time& time)
     {
+        mSimulation.transition(time);
         if (mPhase == OUT) {
             removeReadyTransports();
         }
@@ -219,40 +265,43 @@ public:
     {
         vle::devs::ExternalEventList::const_iterator it = events.begin();
 
-        while (it != events.end()) {
-            if ((*it)->onPort("container")) {
-                Container* container = new Container(
-                    vle::value::toMapValue(
-                        (*it)->getAttributeValue("container")));
+        mSimulation.received(events.size());
+        mSimulation.transition(time);
 
-                std::cout << time << " - [" << getModelName()
-                          << "] TRANSIT CONTAINER: " << container->toString()
-                          << std::endl;
-
-                container->arrived(time);
-                mWaitingContainers.push_back(container);
+        while (it != events.end()) {
+            if ((*it)->onPort("container") and
+                (*it)->existAttributeValue("containers")) {
+                ContainersPayload::handle_type batch =
+                    toContainers((*it)->getAttributeValue("containers"),
+                                 mSimulation);
+
+                for (SharedContainers::const_iterator itc = batch->begin();
+                     itc != batch->end(); ++itc) {
+                    addContainer(**itc, time);
+                }
+            } else if ((*it)->onPort("container")) {
+                addContainer(*toContainer(
+                                 (*it)->getAttributeValue("container"),
+                                 mSimulation), time);
             } else if ((*it)->onPort("load")) {
-                Transport* transport = new Transport(
-                    vle::value::toMapValue(
-                        (*it)->getAttributeValue("transport")));
+                Transport* transport =
+                    new (mSimulation.transports()) Transport(
+                        *toTransport((*it)->getAttributeValue("transport"),
+                                     mSimulation));
 
-                std::cout << time << " - [" << getModelName()
-                          << "] TRANSIT LOAD: " << transport->id()
-                          << std::endl;
+                LOGISTICS_INFO(mLog, time, "TRANSIT LOAD: "
+                               << transport->id());
 
                 mWaitingTransports.push_back(transport);
 
-                std::cout << time << " - [" << getModelName()
-                          << "] TRANSIT LOAD: wait = "
-                          << mWaitingTransports.size() << std::endl;
-
+                LOGISTICS_DEBUG(mLog, time, "TRANSIT LOAD: wait = "
+                                << mWaitingTransports.size());
             } else if ((*it)->onPort("depart")) {
                 TransportID transportID =
                     (TransportID)(*it)->getIntegerAttributeValue("id");
 
-                std::cout << time << " - [" << getModelName()
-                          << "] TRANSIT DEPART: " << transportID
-                          << std::endl;
+                LOGISTICS_INFO(mLog, time, "TRANSIT DEPART: "
+                               << transportID);
 
                 mReadyTransports.push_back(transportID);
                 mPhase = OUT;
@@ -260,19 +309,13 @@ public:
             ++it;
         }
         if (not mWaitingTransports.empty() and mWaitingContainers.size() > 0) {
+            bool loaded = loadContainers();
 
-            std::cout << time << " - [" << getModelName()
-                      << "] TRANSIT LOADING";
-
-            if (loadContainers()) {
-
-                std::cout << " ==> loaded" << std::endl;
-
+            LOGISTICS_INFO(mLog, time, "TRANSIT LOADING"
+                           << (loaded ? " ==> loaded" : ""));
+            if (loaded) {
                 mPhase = LOADED;
             }
-
-            std::cout  << std::endl;
-
         }
     }
 
@@ -284,41 +327,20 @@ public:
         } else if (event.onPort("waiting")) {
             return vle::value::Integer::create(mWaitingTransports.size());
         } else if (event.onPort("time-in-transit")) {
-            double t = 0;
-            Containers::const_iterator it = mWaitingContainers.begin();
-
-            while (it != mWaitingContainers.end()) {
-                double e = event.getTime() - (*it)->arrivalDate();
-
-                if (e > 0 ) {
-                    t += e;
-                }
-                ++it;
-            }
             if (mWaitingContainers.empty()) {
                 return vle::value::Double::create(0);
             } else {
                 return vle::value::Double::create(
-                    t / mWaitingContainers.size());
+                    mWaitingContainers.timeInTransit(event.getTime()) /
+                    mWaitingContainers.size());
             }
         } else if (event.onPort("transport-lateness")) {
-            double t = 0;
-            OrderedTransportList::const_iterator it =
-                mWaitingTransports.begin();
-
-            while (it != mWaitingTransports.end()) {
-                double e = event.getTime() - (*it)->departureDate();
-
-                if (e > 0 ) {
-                    t += e;
-                }
-                ++it;
-            }
             if (mWaitingTransports.empty()) {
                 return vle::value::Double::create(0);
             } else {
                 return vle::value::Double::create(
-                    t / mWaitingTransports.size());
+                    mWaitingTransports.lateness(event.getTime()) /
+                    mWaitingTransports.size());
             }
         } else {
             return 0;
@@ -328,10 +350,14 @@ public:
 private:
     enum phase { IDLE, LOADED, OUT };
 
+    Simulation& mSimulation;
+    Logger mLog;
+
     // state
     phase mPhase;
 
-    Containers mWaitingContainers;
+    WaitingContainers mWaitingContainers;
+    Loading mLoading;
     OrderedTransportList mWaitingTransports;
     LoadingTransports mLoadingTransports;
     ReadyTransports mReadyTransports;
@@ -339,4 +365,11 @@ private:
 
 } // namespace logistics
 
-DECLARE_NAMED_DYNAMICS(Transit, logistics::Transit);
+DECLARE_NAMED_DYNAMICS(Transit,
+                       logistics::Transit < logistics::EarliestExigibility >);
+DECLARE_NAMED_DYNAMICS(TransitFifo,
+                       logistics::Transit < logistics::FirstInFirstOut >);
+DECLARE_NAMED_DYNAMICS(TransitDestination,
+                       logistics::Transit < logistics::DestinationMatching >);
+DECLARE_NAMED_DYNAMICS(
+    TransitLateness, logistics::Transit < logistics::LatenessWeighted < 50 > >);
@@ -27,6 +27,11 @@
 #include <vle/value/Map.hpp>
 #include <vle/devs/Time.hpp>
 #include <Container.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/unordered_map.hpp>
+#include <list>
+#include <map>
+#include <set>
 
 using namespace vle::devs;
 using namespace vle::value;
@@ -37,11 +42,11 @@ enum TransportType { BOAT = 0, TRUCK = 1, TRAIN = 2 };
 
 typedef unsigned int TransportID;
 
-class Transport
+class Transport : public Pooled
 {
 public:
     Transport(TransportID id, TransportType type,
-              double capacity, const std::string& destination,
+              double capacity, LocationID destination,
               ContentType contentType, Time departureDate) :
         mID(id), mType(type), mCapacity(capacity), mDestination(destination),
         mContentType(contentType), mDepartureDate(departureDate)
@@ -52,12 +57,24 @@ public:
         mID = (TransportID)toInteger(value.get("Id"));
         mType = (TransportType)toInteger(value.get("Type"));
         mCapacity = toDouble(value.get("Capacity"));
-        mDestination = vle::value::toString(value.get("Destination"));
+        mDestination =
+            Locations::id(vle::value::toString(value.get("Destination")));
         mContentType =
             (ContentType)toInteger(value.get("ContentType"));
         mDepartureDate = (Time)toDouble(value.get("DepartureDate"));
     }
 
+    Transport(CheckpointReader& in)
+    {
+        mID = in.get < boost::uint32_t >();
+        mType = (TransportType)in.get < boost::uint8_t >();
+        in.read(mCapacity);
+        mDestination = in.location();
+        mContentType = (ContentType)in.get < boost::uint8_t >();
+        in.read(mDepartureDate);
+        in.read(mArrivalDate);
+    }
+
     virtual ~Transport()
     { }
 
@@ -71,7 +88,7 @@ public:
         std::ostringstream str;
 
         str << "Transport[ " << mID << " " << mType << " " << mCapacity
-            << " " << mDestination
+            << " " << Locations::name(mDestination)
             << " " << ((mContentType == FOOD) ? "FOOD" : "NOFOOD")
             << " " << mDepartureDate << " ] ";
         return str.str();
@@ -84,19 +101,31 @@ public:
         value->addInt("Id", (int)mID);
         value->addInt("Type", (int)mType);
         value->addDouble("Capacity", mCapacity);
-        value->addString("Destination", mDestination);
+        value->addString("Destination",
+                         Locations::name(mDestination));
         value->addInt("ContentType", mContentType);
         value->addDouble("DepartureDate", mDepartureDate.getValue());
         return value;
     }
 
+    void save(CheckpointWriter& out) const
+    {
+        out.write((boost::uint32_t)mID);
+        out.write((boost::uint8_t)mType);
+        out.write(mCapacity);
+        out.location(mDestination);
+        out.write((boost::uint8_t)mContentType);
+        out.write(mDepartureDate);
+        out.write(mArrivalDate);
+    }
+
     int capacity() const
     { return mCapacity; }
 
     Time departureDate() const
     { return mDepartureDate; }
 
-    std::string destination() const
+    LocationID destination() const
     { return mDestination; }
 
     TransportID id() const
@@ -112,12 +141,14 @@ private:
     TransportID mID;
     TransportType mType;
     double mCapacity;
-    std::string mDestination;
+    LocationID mDestination;
     ContentType mContentType;
     Time mDepartureDate;
     Time mArrivalDate;
 };
 
+typedef boost::shared_ptr < const Transport > TransportHandle;
+
 class Transports : public std::vector < Transport* >
 {
 public:
@@ -136,6 +167,26 @@ public:
         std::vector < Transport* >::clear();
     }
 
+    void save(CheckpointWriter& out) const
+    {
+        out.write((boost::uint32_t)size());
+        for (const_iterator it = begin(); it != end(); ++it) {
+            (*it)->save(out);
+        }
+    }
+
+    /**
+     * Append the transports written by save(), created in pool.
+     */
+    void restore(CheckpointReader& in, ObjectPool& pool)
+    {
+        boost::uint32_t n = in.get < boost::uint32_t >();
+
+        for (boost::uint32_t i = 0; i < n; ++i) {
+            push_back(new (pool) Transport(in));
+        }
+    }
+
     std::string toString() const
     {
         std::string str = "{ ";
@@ -148,26 +199,229 @@ public:
     }
 };
 
-class OrderedTransportList : public std::list < Transport* >
+/**
+ * Transports docked on a platform, ordered by departure date. Transports
+ * sharing the same departure date are kept in arrival order.
+ */
+class DepartureSchedule : public std::multimap < Time, Transport* >
 {
 public:
-    Transport* find(const TransportID& id) const
+    virtual ~DepartureSchedule()
+    {
+        for (const_iterator it = begin(); it != end(); ++it) {
+            delete it->second;
+        }
+    }
+
+    void add(Transport* transport)
+    {
+        insert(std::make_pair(transport->departureDate(), transport));
+    }
+
+    /**
+     * Append to transports, earliest first, every transport whose
+     * departure date is before time, or strictly within tolerance of it:
+     * a transport that arrived after its departure date is due as soon
+     * as it arrives.
+     */
+    void due(const Time& time, double tolerance,
+             std::vector < Transport* >& transports) const
     {
-        bool found = false;
         const_iterator it = begin();
-        Transport* transport = 0;
 
-        while (not found and it != end()) {
-            if ((*it)->id() == id) {
-                transport = *it;
-                found = true;
-            } else {
-                ++it;
+        while (it != end() and it->first - time < tolerance) {
+            transports.push_back(it->second);
+            ++it;
+        }
+    }
+
+    Time next() const
+    {
+        return empty() ? Time::infinity : begin()->first;
+    }
+
+    void remove(Transport* transport)
+    {
+        std::pair < iterator, iterator > range =
+            equal_range(transport->departureDate());
+
+        for (iterator it = range.first; it != range.second; ++it) {
+            if (it->second == transport) {
+                erase(it);
+                return;
+            }
+        }
+    }
+
+    /**
+     * Write the transports in schedule order, so that restore() keeps
+     * the arrival order of those leaving at the same date.
+     */
+    void save(CheckpointWriter& out) const
+    {
+        out.write((boost::uint32_t)size());
+        for (const_iterator it = begin(); it != end(); ++it) {
+            it->second->save(out);
+        }
+    }
+
+    void restore(CheckpointReader& in, ObjectPool& pool)
+    {
+        boost::uint32_t n = in.get < boost::uint32_t >();
+
+        for (boost::uint32_t i = 0; i < n; ++i) {
+            add(new (pool) Transport(in));
+        }
+    }
+};
+
+/**
+ * Sum, at a given time, of the delays past a set of dates, dates still
+ * to come counting for nothing. The dates are kept sorted with a cursor
+ * on the first one that is not past yet, together with the count and the
+ * exact sum of the past ones (see ExactSum.hpp); as observation times
+ * only move forward, each date crosses the cursor once and sum() is O(1)
+ * amortized.
+ */
+class Lateness
+{
+public:
+    Lateness() :
+        mTime(-Time::infinity), mCount(0)
+    {
+        mCursor = mDates.end();
+    }
+
+    void add(double date)
+    {
+        Dates::iterator it = mDates.insert(date);
+
+        if (date < mTime) {
+            ++mCount;
+            mSum.add(date);
+        } else if (mCursor == mDates.end() or date < *mCursor) {
+            mCursor = it;
+        }
+    }
+
+    void remove(double date)
+    {
+        Dates::iterator it = mDates.find(date);
+
+        if (it != mDates.end()) {
+            if (date < mTime) {
+                --mCount;
+                mSum.subtract(date);
+            } else if (it == mCursor) {
+                ++mCursor;
+            }
+            mDates.erase(it);
+        }
+    }
+
+    double sum(const Time& time) const
+    {
+        mTime = time.getValue();
+        while (mCursor != mDates.end() and *mCursor < mTime) {
+            ++mCount;
+            mSum.add(*mCursor);
+            ++mCursor;
+        }
+        while (mCursor != mDates.begin()) {
+            Dates::iterator previous = mCursor;
+
+            if (*--previous < mTime) {
+                break;
             }
+            --mCount;
+            mSum.subtract(*previous);
+            mCursor = previous;
+        }
+        return mSum.elapsed(mCount, mTime);
+    }
+
+private:
+    typedef std::multiset < double > Dates;
+
+    Dates mDates;
+    mutable Dates::iterator mCursor;
+    mutable double mTime;
+    mutable unsigned long mCount;
+    mutable ExactSum mSum;
+};
+
+/**
+ * Transports waiting in a transit zone, in arrival order. A hashed index
+ * maps each transport identifier to its node so that find() and erase()
+ * do not walk the list, and the departure dates are kept aggregated for
+ * the lateness observation.
+ */
+class OrderedTransportList : private std::list < Transport* >
+{
+public:
+    typedef std::list < Transport* > list_type;
+
+    using list_type::const_iterator;
+    using list_type::begin;
+    using list_type::end;
+    using list_type::empty;
+    using list_type::size;
+
+    void push_back(Transport* transport)
+    {
+        list_type::push_back(transport);
+        mIndex[transport->id()] = --list_type::end();
+        mLateness.add(transport->departureDate().getValue());
+    }
+
+    Transport* find(const TransportID& id) const
+    {
+        Index::const_iterator it = mIndex.find(id);
+
+        return it == mIndex.end() ? 0 : *it->second;
+    }
+
+    /**
+     * Sum over the waiting transports of the delay past their departure
+     * date at time.
+     */
+    double lateness(const Time& time) const
+    { return mLateness.sum(time); }
+
+    Transport* erase(const TransportID& id)
+    {
+        Index::iterator it = mIndex.find(id);
+        Transport* transport = 0;
+
+        if (it != mIndex.end()) {
+            transport = *it->second;
+            list_type::erase(it->second);
+            mIndex.erase(it);
+            mLateness.remove(transport->departureDate().getValue());
         }
         return transport;
     }
 
+    void save(CheckpointWriter& out) const
+    {
+        out.write((boost::uint32_t)size());
+        for (const_iterator it = begin(); it != end(); ++it) {
+            (*it)->save(out);
+        }
+    }
+
+    /**
+     * Append the transports written by save(), created in pool.
+     */
+    void restore(CheckpointReader& in, ObjectPool& pool)
+    {
+        boost::uint32_t n = in.get < boost::uint32_t >();
+
+        for (boost::uint32_t i = 0; i < n; ++i) {
+            push_back(new (pool) Transport(in));
+        }
+    }
+
     std::string toString() const
     {
         std::string str = "{ ";
@@ -178,9 +432,15 @@ public:
         str += "}";
         return str;
     }
+
+private:
+    typedef boost::unordered_map < TransportID, list_type::iterator > Index;
+
+    Index mIndex;
+    Lateness mLateness;
 };
 
-typedef std::map < TransportID, Containers > LoadingTransports;
+typedef std::map < TransportID, SharedContainers > LoadingTransports;
 
 typedef std::vector < TransportID > ReadyTransports;
 
@@ -23,7 +23,11 @@
 
 #include <vle/devs/Dynamics.hpp>
 #include <vle/utils/Rand.hpp>
-#include <Transport.hpp>
+#include <Payload.hpp>
+#include <Random.hpp>
+#include <Trace.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <limits>
 
 namespace logistics {
 
@@ -32,92 +36,207 @@ class TransportGenerator : public vle::devs::Dynamics
 public:
     TransportGenerator(const vle::devs::DynamicsInit& init,
                      const vle::devs::InitEventList& events) :
-        vle::devs::Dynamics(init, events)
+        vle::devs::Dynamics(init, events),
+        mSimulation(Simulation::acquire(getModel(), events)),
+        mLog(getModelName(), events)
     {
-        mContainerPresent =
-            vle::value::toBoolean(events.get("ContainerPresent"));
-        mTransportType =
-            (TransportType)vle::value::toInteger(events.get("TransportType"));
-        mMinCapacity = vle::value::toInteger(events.get("MinCapacity"));
-        mMaxCapacity = vle::value::toInteger(events.get("MaxCapacity"));
-        mMinDuration = vle::value::toDouble(events.get("MinDuration"));
-        mMaxDuration = vle::value::toDouble(events.get("MaxDuration"));
-        mMinStayDuration =
-            vle::value::toDouble(events.get("MinStayDuration"));
-        mMaxStayDuration =
-            vle::value::toDouble(events.get("MaxStayDuration"));
-
-        {
-            const vle::value::Set* values =
-                vle::value::toSetValue(events.get("Destinations"));
-
-            for (unsigned int i = 0; i < values->size(); ++i) {
-                mDestinationNames.push_back(
-                    vle::value::toString(values->get(i)));
+        // replay mode: the transports and their containers are read from
+        // the binary trace named by the Trace condition (see Trace.hpp)
+        // instead of being drawn
+        if (events.exist("Trace")) {
+            mContainerPresent = true;
+            mTrace.reset(new TraceReader(
+                             vle::value::toString(events.get("Trace"))));
+        } else {
+            mContainerPresent =
+                vle::value::toBoolean(events.get("ContainerPresent"));
+            mTransportType = (TransportType)vle::value::toInteger(
+                events.get("TransportType"));
+            mMinCapacity = vle::value::toInteger(events.get("MinCapacity"));
+            mMaxCapacity = vle::value::toInteger(events.get("MaxCapacity"));
+            mMinDuration = vle::value::toDouble(events.get("MinDuration"));
+            mMaxDuration = vle::value::toDouble(events.get("MaxDuration"));
+            mMinStayDuration =
+                vle::value::toDouble(events.get("MinStayDuration"));
+            mMaxStayDuration =
+                vle::value::toDouble(events.get("MaxStayDuration"));
+
+            {
+                const vle::value::Set* values =
+                    vle::value::toSetValue(events.get("Destinations"));
+
+                for (unsigned int i = 0; i < values->size(); ++i) {
+                    mDestinations.push_back(
+                        Locations::id(vle::value::toString(values->get(i))));
+                }
             }
-        }
 
-        if (mContainerPresent) {
-            mMinSize = vle::value::toInteger(events.get("MinSize"));
-            mMinTravelDuration =
-                vle::value::toDouble(events.get("MinTravelDuration"));
-            mMaxTravelDuration =
-                vle::value::toDouble(events.get("MaxTravelDuration"));
+            if (mContainerPresent) {
+                mMinSize = vle::value::toInteger(events.get("MinSize"));
+                mMinTravelDuration =
+                    vle::value::toDouble(events.get("MinTravelDuration"));
+                mMaxTravelDuration =
+                    vle::value::toDouble(events.get("MaxTravelDuration"));
+            }
+
+            // one draw from the kernel generator seeds the block stream
+            mRandom.seed((boost::uint64_t)rand().getInt(
+                             0, std::numeric_limits < int >::max()));
         }
     }
 
+    virtual ~TransportGenerator()
+    {
+        Simulation::release(mSimulation);
+    }
+
     void generateContainers(const vle::devs::Time& time, unsigned int capacity)
     {
         unsigned int size = (mMinSize < capacity) ?
-            rand().getInt(mMinSize, capacity) : capacity;
+            mRandom.getInt(mMinSize, capacity) : capacity;
 
-        std::cout << time << " - [" << getModelName()
-                  << "] CONTAINERS GENERATE: " << size << std::endl;
+        LOGISTICS_INFO(mLog, time, "CONTAINERS GENERATE: " << size);
 
         for (unsigned int i = 0; i < size; ++i) {
-            std::string source =
-                mDestinationNames[rand().getInt(0,
-                                                mDestinationNames.size() - 1)];
-            std::string destination =
-                mDestinationNames[rand().getInt(0,
-                                                mDestinationNames.size() - 1)];
-            ContentType type = rand().getBool() ? FOOD : NOFOOD;
+            LocationID source =
+                mDestinations[mRandom.getInt(0, mDestinations.size() - 1)];
+            LocationID destination =
+                mDestinations[mRandom.getInt(0, mDestinations.size() - 1)];
+            ContentType type = mRandom.getBool() ? FOOD : NOFOOD;
             vle::devs::Time exigibilityDate =
-                time + rand().getDouble(mMinTravelDuration, mMaxTravelDuration);
+                time + mRandom.getDouble(mMinTravelDuration, mMaxTravelDuration);
 
-            mContainers.add(
-                new Container(mContainerID++, source, destination,
-                              type, exigibilityDate));
+            mContainers->push_back(ContainerHandle(
+                    new (mSimulation.containers())
+                    Container(mSimulation.newContainerID(), source,
+                              destination, type, exigibilityDate)));
         }
     }
 
     void generateTransport(const vle::devs::Time& time)
     {
-        unsigned int capacity = rand().getInt(mMinCapacity, mMaxCapacity);
-        std::string destination =
-            mDestinationNames[rand().getInt(0, mDestinationNames.size() - 1)];
-        ContentType type = rand().getBool() ? FOOD : NOFOOD;
+        unsigned int capacity = mRandom.getInt(mMinCapacity, mMaxCapacity);
+        LocationID destination =
+            mDestinations[mRandom.getInt(0, mDestinations.size() - 1)];
+        ContentType type = mRandom.getBool() ? FOOD : NOFOOD;
         vle::devs::Time departureDate =
-            time + rand().getDouble(mMinStayDuration, mMaxStayDuration);
+            time + mRandom.getDouble(mMinStayDuration, mMaxStayDuration);
 
-        mTransport = new Transport(mTransportID++, mTransportType,
-                                   capacity, destination,
-                                   type, departureDate);
+        mTransport.reset(new (mSimulation.transports())
+                         Transport(mSimulation.newTransportID(),
+                                   mTransportType, capacity, destination,
+                                   type, departureDate));
+        mContainers.reset(new SharedContainers);
         if (mContainerPresent) {
             generateContainers(time, capacity);
         }
     }
 
-    vle::devs::Time nextDate() const
+    /**
+     * Replay mode: the transport at the head of the trace, with its
+     * containers, then move on. They are given new identifiers from the
+     * sequences of the simulation, as generated ones are, so that they
+     * cannot collide with those of the other generators; nothing refers
+     * to the identifiers of the trace.
+     */
+    void readTransport()
     {
-        return rand().getDouble(mMinDuration, mMaxDuration);
+        const TraceTransport& transport = mTrace->transport();
+        const TraceContainer* containers = mTrace->containers();
+
+        mTransport.reset(new (mSimulation.transports())
+                         Transport(mSimulation.newTransportID(),
+                                   (TransportType)transport.type,
+                                   transport.capacity,
+                                   mTrace->location(transport.destination),
+                                   (ContentType)transport.content,
+                                   transport.departure));
+        mContainers.reset(new SharedContainers);
+        mContainers->reserve(transport.containers);
+        for (boost::uint16_t i = 0; i < transport.containers; ++i) {
+            mContainers->push_back(ContainerHandle(
+                    new (mSimulation.containers())
+                    Container(mSimulation.newContainerID(),
+                              mTrace->location(containers[i].source),
+                              mTrace->location(containers[i].destination),
+                              (ContentType)containers[i].content,
+                              containers[i].exigibility)));
+        }
+
+        LOGISTICS_INFO(mLog, mTime, "CONTAINERS REPLAY: "
+                       << transport.containers);
+
+        mTrace->next();
+    }
+
+    vle::devs::Time nextDate()
+    {
+        if (mTrace) {
+            if (mTrace->empty()) {
+                return vle::devs::Time::infinity;
+            }
+            return std::max(0., mTrace->transport().arrival -
+                            mTime.getValue());
+        }
+        return mRandom.getDouble(mMinDuration, mMaxDuration);
     }
 
-    vle::devs::Time init(const vle::devs::Time& /* time */)
+    vle::devs::Time init(const vle::devs::Time& time)
     {
-        mTransport = 0;
         mPhase = IDLE;
-        return nextDate();
+        mTime = time;
+        if (const Checkpoint* checkpoint = mSimulation.restored(time)) {
+            CheckpointReader in(*checkpoint, getModel());
+
+            restore(in, time);
+        } else {
+            mSigma = nextDate();
+        }
+        return mSigma;
+    }
+
+    /*
+     * The date of the next transport is saved rather than sigma, which
+     * counts from the last transition.
+     */
+    void finish()
+    {
+        if (Checkpoint* checkpoint = mSimulation.checkpoint()) {
+            CheckpointWriter out(*checkpoint, getModel());
+
+            out.write((boost::uint8_t)mPhase);
+            out.write(mTime);
+            out.write(mTime + mSigma);
+            if (mTrace) {
+                out.write(mTrace->offset());
+            } else {
+                mRandom.save(out);
+            }
+            if (mPhase == SEND) {
+                mTransport->save(out);
+                mContainers->save(out);
+            }
+        }
+    }
+
+    void restore(CheckpointReader& in, const vle::devs::Time& time)
+    {
+        vle::devs::Time next;
+
+        mPhase = (phase)in.get < boost::uint8_t >();
+        in.read(mTime);
+        in.read(next);
+        mSigma = next.getValue() - time.getValue();
+        if (mTrace) {
+            mTrace->seek(in.get < boost::uint64_t >());
+        } else {
+            mRandom.restore(in);
+        }
+        if (mPhase == SEND) {
+            mTransport.reset(new (mSimulation.transports()) Transport(in));
+            mContainers.reset(
+                new SharedContainers(in, mSimulation.containers()));
+        }
     }
 
     void output(const vle::devs::Time& /* time */,
@@ -126,32 +245,36 @@ public:
         if (mPhase == SEND) {
             vle::devs::ExternalEvent* ee = new vle::devs::ExternalEvent("out");
 
-            ee << vle::devs::attribute("transport", mTransport->toValue());
-            ee << vle::devs::attribute("containers", mContainers.toValue());
+            ee << vle::devs::attribute("transport",
+                                       new TransportPayload(mTransport));
+            ee << vle::devs::attribute("containers",
+                                       new ContainersPayload(mContainers));
             output.addEvent(ee);
         }
     }
 
     vle::devs::Time timeAdvance() const
     {
-        if (mPhase == IDLE) {
-            return nextDate();
-        } else if (mPhase == SEND) {
-            return 0;
-        }
-        return vle::devs::Time::infinity;
+        return mSigma;
     }
 
     void internalTransition(const vle::devs::Time& time)
     {
+        mSimulation.transition(time);
+        mTime = time;
         if (mPhase == IDLE) {
-            generateTransport(time);
+            if (mTrace) {
+                readTransport();
+            } else {
+                generateTransport(time);
+            }
             mPhase = SEND;
+            mSigma = 0;
         } else if (mPhase == SEND) {
-            delete mTransport;
-            mTransport = 0;
-            mContainers.clear();
+            mTransport.reset();
+            mContainers.reset();
             mPhase = IDLE;
+            mSigma = nextDate();
         }
     }
 
@@ -175,19 +298,24 @@ private:
     double mMinTravelDuration;
     double mMaxTravelDuration;
 
-    std::vector < std::string > mDestinationNames;
+    std::vector < LocationID > mDestinations;
+
+    // replay mode
+    boost::scoped_ptr < TraceReader > mTrace;
+
+    Simulation& mSimulation;
+    Logger mLog;
+
+    RandomStream mRandom;
 
     // state
     phase mPhase;
-    static int mTransportID;
-    Transport* mTransport;
-    static int mContainerID;
-    Containers mContainers;
+    vle::devs::Time mSigma;
+    vle::devs::Time mTime;
+    TransportHandle mTransport;
+    boost::shared_ptr < SharedContainers > mContainers;
 };
 
-int TransportGenerator::mTransportID = 0;
-int TransportGenerator::mContainerID = 0;
-
 } // namespace logistics
 
 DECLARE_NAMED_DYNAMICS(TransportGenerator, logistics::TransportGenerator);
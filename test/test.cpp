@@ -29,6 +29,30 @@
 #include <boost/test/unit_test.hpp>
 #include <boost/test/auto_unit_test.hpp>
 #include <boost/test/floating_point_comparison.hpp>
+#include <vle/graph/AtomicModel.hpp>
+#include <vle/graph/CoupledModel.hpp>
+#include <Checkpoint.hpp>
+#include <Columnar.hpp>
+#include <Container.hpp>
+#include <Loading.hpp>
+#include <Log.hpp>
+#include <Payload.hpp>
+#include <Random.hpp>
+#include <Simulation.hpp>
+#include <Trace.hpp>
+#include <Transport.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <cstdio>
+#include <cstdlib>
+#include <set>
+#include <sstream>
+
+extern "C" {
+vle::devs::Dynamics* makeNewDynamicsDecision(
+    const vle::devs::DynamicsInit&, const vle::devs::InitEventList&);
+vle::devs::Dynamics* makeNewDynamicsTransportGenerator(
+    const vle::devs::DynamicsInit&, const vle::devs::InitEventList&);
+}
 
 BOOST_AUTO_TEST_CASE(test_1)
 {
@@ -37,3 +61,682 @@ BOOST_AUTO_TEST_CASE(test_1)
     BOOST_REQUIRE(1 == 1);
     BOOST_TEST_MESSAGE("test");
 }
+
+BOOST_AUTO_TEST_CASE(waiting_containers_order)
+{
+    logistics::WaitingContainers containers;
+    logistics::LocationID a = logistics::Locations::id("A");
+    logistics::LocationID b = logistics::Locations::id("B");
+
+    containers.add(new logistics::Container(0, a, b, logistics::FOOD, 3.));
+    containers.add(new logistics::Container(1, a, b, logistics::FOOD, 1.));
+    containers.add(new logistics::Container(2, a, b, logistics::FOOD, 3.));
+    containers.add(new logistics::Container(3, a, b, logistics::FOOD, 1.));
+
+    unsigned int expected[] = { 1, 3, 0, 2 };
+
+    for (unsigned int i = 0; i < 4; ++i) {
+        logistics::Container* container = containers.pop();
+
+        BOOST_REQUIRE(container != 0);
+        BOOST_REQUIRE_EQUAL(container->id(), expected[i]);
+        delete container;
+    }
+    BOOST_REQUIRE(containers.pop() == 0);
+}
+
+BOOST_AUTO_TEST_CASE(map_form_names)
+{
+    logistics::Container container(5, logistics::Locations::id("A"),
+                                   logistics::Locations::id("Platform3"),
+                                   logistics::NOFOOD, 2.5);
+    boost::scoped_ptr < vle::value::Value > value(container.toValue());
+    const vle::value::Map& map = vle::value::toMapValue(*value);
+
+    BOOST_REQUIRE_EQUAL(vle::value::toString(map.get("Source")), "A");
+    BOOST_REQUIRE_EQUAL(vle::value::toString(map.get("Destination")),
+                        "Platform3");
+
+    logistics::Container copy(map);
+
+    BOOST_REQUIRE_EQUAL(copy.id(), 5u);
+    BOOST_REQUIRE_EQUAL(copy.destination(),
+                        logistics::Locations::id("Platform3"));
+}
+
+template < class Loading >
+logistics::ContainerID selected(
+    const logistics::WaitingContainers& containers,
+    const logistics::Transport& transport)
+{
+    Loading loading;
+
+    for (logistics::ContainerSlot i = 0; i < containers.size(); ++i) {
+        logistics::Container* container = containers.container(i);
+
+        loading.add(container, containers.rank(container));
+    }
+    return loading.select(containers, transport)->id();
+}
+
+BOOST_AUTO_TEST_CASE(loading_policies)
+{
+    logistics::WaitingContainers containers;
+    logistics::LocationID a = logistics::Locations::id("A");
+    logistics::LocationID b = logistics::Locations::id("B");
+    logistics::LocationID c = logistics::Locations::id("C");
+    double exigibilities[] = { 3.4, 3., 4., 3. };
+    double arrivals[] = { 0., 1., 2., 9. };
+    logistics::LocationID destinations[] = { b, c, b, b };
+
+    for (unsigned int i = 0; i < 4; ++i) {
+        logistics::Container* container = new logistics::Container(
+            i, a, destinations[i], logistics::FOOD, exigibilities[i]);
+
+        container->arrived(arrivals[i]);
+        containers.add(container);
+    }
+
+    logistics::Transport toB(0, logistics::TRUCK, 1, b, logistics::FOOD, 0.);
+    logistics::Transport toA(1, logistics::TRUCK, 1, a, logistics::FOOD, 0.);
+
+    BOOST_REQUIRE_EQUAL(selected < logistics::EarliestExigibility >(
+                            containers, toB), 1u);
+    BOOST_REQUIRE_EQUAL(selected < logistics::FirstInFirstOut >(
+                            containers, toB), 0u);
+    BOOST_REQUIRE_EQUAL(selected < logistics::DestinationMatching >(
+                            containers, toB), 3u);
+    BOOST_REQUIRE_EQUAL(selected < logistics::DestinationMatching >(
+                            containers, toA), 1u);
+    BOOST_REQUIRE_EQUAL(selected < logistics::LatenessWeighted < 50 > >(
+                            containers, toB), 0u);
+
+    // a loaded container leaves the index of the policy
+    logistics::DestinationMatching loading;
+
+    for (logistics::ContainerSlot i = 0; i < containers.size(); ++i) {
+        logistics::Container* container = containers.container(i);
+
+        loading.add(container, containers.rank(container));
+    }
+    for (unsigned int i = 0; i < 3; ++i) {
+        logistics::Container* container = loading.select(containers, toB);
+
+        BOOST_REQUIRE_EQUAL(container->id(), i == 0 ? 3u : i == 1 ? 0u : 2u);
+        loading.remove(container, containers.rank(container));
+        containers.remove(container);
+        delete container;
+    }
+    BOOST_REQUIRE_EQUAL(loading.select(containers, toB)->id(), 1u);
+    while (logistics::Container* container = containers.pop()) {
+        delete container;
+    }
+}
+
+BOOST_AUTO_TEST_CASE(lateness_sum)
+{
+    logistics::Lateness lateness;
+    std::vector < double > dates;
+    double time = 0;
+
+    std::srand(1);
+    for (unsigned int i = 0; i < 2000; ++i) {
+        if (dates.empty() or std::rand() % 3) {
+            double date = time + std::rand() % 40 - 10;
+
+            dates.push_back(date);
+            lateness.add(date);
+        } else {
+            unsigned int j = std::rand() % dates.size();
+
+            lateness.remove(dates[j]);
+            dates.erase(dates.begin() + j);
+        }
+        // mostly forward, sometimes backward
+        time += std::rand() % 5 - 1;
+
+        double expected = 0;
+
+        for (unsigned int j = 0; j < dates.size(); ++j) {
+            if (time - dates[j] > 0) {
+                expected += time - dates[j];
+            }
+        }
+        BOOST_REQUIRE_CLOSE(lateness.sum(time) + 1., expected + 1., 1e-9);
+    }
+}
+
+namespace {
+
+int evaluations = 0;
+
+int evaluate()
+{
+    return ++evaluations;
+}
+
+}
+
+BOOST_AUTO_TEST_CASE(aggregates_large_dates)
+{
+    // count * time - sum of the dates, in plain doubles, is off by some
+    // 1e-9 here; the aggregates must match a direct sum of the delays
+    logistics::Lateness lateness;
+    logistics::WaitingContainers containers;
+    std::vector < double > dates;
+    logistics::LocationID a = logistics::Locations::id("A");
+    double time = 1e9;
+
+    std::srand(2);
+    for (unsigned int i = 0; i < 1000; ++i) {
+        double date = time - (std::rand() % 100000) / 1000.;
+        logistics::Container* container = new logistics::Container(
+            i, a, a, logistics::FOOD, 0.);
+
+        dates.push_back(date);
+        lateness.add(date);
+        container->arrived(date);
+        containers.add(container);
+    }
+    for (unsigned int i = 0; i < 10; ++i) {
+        double expected = 0;
+
+        time += (std::rand() % 1000) / 7.;
+        for (unsigned int j = 0; j < dates.size(); ++j) {
+            expected += time - dates[j];
+        }
+        BOOST_REQUIRE_CLOSE(lateness.sum(time), expected, 1e-10);
+        BOOST_REQUIRE_CLOSE(containers.timeInTransit(time), expected,
+                            1e-10);
+    }
+    while (logistics::Container* container = containers.pop()) {
+        delete container;
+    }
+}
+
+BOOST_AUTO_TEST_CASE(log_lazy_arguments)
+{
+    vle::value::Map conditions;
+
+    conditions.addString("log-level", "info");
+
+    logistics::Logger log("model", conditions);
+
+    BOOST_REQUIRE(log.enabled(logistics::LEVEL_INFO));
+    BOOST_REQUIRE(not log.enabled(logistics::LEVEL_DEBUG));
+    LOGISTICS_DEBUG(log, 0., "debug " << evaluate());
+    BOOST_REQUIRE_EQUAL(evaluations, 0);
+    LOGISTICS_INFO(log, 0., "info " << evaluate());
+    BOOST_REQUIRE_EQUAL(evaluations, 1);
+    logistics::LogSink::instance().flush();
+}
+
+BOOST_AUTO_TEST_CASE(trace_round_trip)
+{
+    std::string path = "trace_round_trip.trace";
+
+    {
+        logistics::TraceWriter writer(path);
+        logistics::TraceTransport transport;
+        std::vector < logistics::TraceContainer > containers(2);
+
+        std::memset(&transport, 0, sizeof(transport));
+        std::memset(&containers[0], 0, 2 * sizeof(containers[0]));
+        transport.arrival = 1.5;
+        transport.id = 7;
+        transport.type = logistics::TRUCK;
+        transport.destination = writer.location("Platform2");
+        containers[0].id = 70;
+        containers[0].destination = writer.location("B");
+        containers[1].id = 71;
+        containers[1].content = logistics::NOFOOD;
+        containers[1].destination = writer.location("Platform2");
+        writer.add(transport, containers);
+        transport.arrival = 2.;
+        transport.id = 8;
+        writer.add(transport, std::vector < logistics::TraceContainer >());
+        transport.arrival = 1.;
+        BOOST_REQUIRE_THROW(writer.add(transport, containers),
+                            vle::utils::ArgError);
+        writer.close();
+    }
+
+    logistics::TraceReader reader(path);
+
+    BOOST_REQUIRE(not reader.empty());
+    BOOST_REQUIRE_EQUAL(reader.transport().id, 7u);
+    BOOST_REQUIRE_EQUAL(reader.transport().containers, 2);
+    BOOST_REQUIRE_EQUAL(reader.location(reader.transport().destination),
+                        logistics::Locations::id("Platform2"));
+    BOOST_REQUIRE_EQUAL(reader.containers()[1].id, 71u);
+    BOOST_REQUIRE_EQUAL(reader.location(reader.containers()[0].destination),
+                        logistics::Locations::id("B"));
+    reader.next();
+    BOOST_REQUIRE_EQUAL(reader.transport().id, 8u);
+    BOOST_REQUIRE_EQUAL(reader.transport().containers, 0);
+    reader.next();
+    BOOST_REQUIRE(reader.empty());
+    std::remove(path.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(replay_next_to_generator)
+{
+    std::string path = "replay_next_to_generator.trace";
+
+    {
+        logistics::TraceWriter writer(path);
+        logistics::TraceTransport transport;
+        std::vector < logistics::TraceContainer > containers(2);
+
+        std::memset(&transport, 0, sizeof(transport));
+        std::memset(&containers[0], 0, 2 * sizeof(containers[0]));
+        transport.capacity = 2;
+        transport.destination = writer.location("Platform2");
+        containers[1].id = 1;
+        for (unsigned int i = 0; i < 4; ++i) {
+            // the identifiers a generator of the same run would draw
+            transport.arrival = 0.5 + i;
+            transport.id = i;
+            transport.containers = 2;
+            writer.add(transport, containers);
+        }
+        writer.close();
+    }
+
+    vle::graph::CoupledModel root("root", 0);
+    vle::graph::AtomicModel replayModel("Replay", &root);
+    vle::graph::AtomicModel generatorModel("Generator", &root);
+    vle::utils::PackageId package;
+    vle::devs::InitEventList replayEvents;
+    vle::devs::InitEventList generatorEvents;
+    vle::value::Set* destinations = vle::value::Set::create();
+
+    replayEvents.addString("Trace", path);
+    replayEvents.addString("log-level", "quiet");
+    destinations->addString("Platform2");
+    generatorEvents.add("Destinations", destinations);
+    generatorEvents.addBoolean("ContainerPresent", true);
+    generatorEvents.addInt("TransportType", logistics::TRUCK);
+    generatorEvents.addInt("MinCapacity", 2);
+    generatorEvents.addInt("MaxCapacity", 4);
+    generatorEvents.addDouble("MinDuration", 0.5);
+    generatorEvents.addDouble("MaxDuration", 1.);
+    generatorEvents.addDouble("MinStayDuration", 1.);
+    generatorEvents.addDouble("MaxStayDuration", 2.);
+    generatorEvents.addInt("MinSize", 1);
+    generatorEvents.addDouble("MinTravelDuration", 1.);
+    generatorEvents.addDouble("MaxTravelDuration", 2.);
+    generatorEvents.addString("log-level", "quiet");
+
+    vle::devs::Dynamics* generators[] = {
+        makeNewDynamicsTransportGenerator(
+            vle::devs::DynamicsInit(replayModel, package), replayEvents),
+        makeNewDynamicsTransportGenerator(
+            vle::devs::DynamicsInit(generatorModel, package),
+            generatorEvents) };
+    vle::devs::Time next[] = { generators[0]->init(0.),
+                               generators[1]->init(0.) };
+    std::set < logistics::TransportID > transports;
+    std::set < logistics::ContainerID > containers;
+    unsigned int sent = 0;
+
+    // both generators run as the kernel would, until the trace is over
+    while (next[0] != vle::devs::Time::infinity) {
+        unsigned int i = next[0] <= next[1] ? 0 : 1;
+        vle::devs::Time time = next[i];
+        vle::devs::ExternalEventList output;
+
+        generators[i]->output(time, output);
+        for (vle::devs::ExternalEventList::const_iterator it =
+                 output.begin(); it != output.end(); ++it) {
+            const logistics::TransportPayload& transport =
+                dynamic_cast < const logistics::TransportPayload& >(
+                    (*it)->getAttributeValue("transport"));
+            const logistics::ContainersPayload& manifest =
+                dynamic_cast < const logistics::ContainersPayload& >(
+                    (*it)->getAttributeValue("containers"));
+
+            BOOST_REQUIRE(transports.insert(
+                              transport.handle()->id()).second);
+            for (logistics::SharedContainers::const_iterator itc =
+                     manifest.handle()->begin();
+                 itc != manifest.handle()->end(); ++itc) {
+                BOOST_REQUIRE(containers.insert((*itc)->id()).second);
+            }
+            ++sent;
+        }
+        output.deleteAndClear();
+        generators[i]->internalTransition(time);
+        next[i] = time + generators[i]->timeAdvance();
+    }
+    BOOST_REQUIRE(sent > 4);
+    delete generators[0];
+    delete generators[1];
+    std::remove(path.c_str());
+}
+
+vle::devs::ExternalEvent* transportEvent(logistics::TransportID id,
+                                         double departure)
+{
+    vle::devs::ExternalEvent* ee = new vle::devs::ExternalEvent("transport");
+
+    ee << vle::devs::attribute(
+        "transport", new logistics::TransportPayload(
+            logistics::TransportHandle(new logistics::Transport(
+                                           id, logistics::TRUCK, 1,
+                                           logistics::Locations::id("A"),
+                                           logistics::FOOD, departure))));
+    return ee;
+}
+
+vle::devs::ExternalEvent* loadedEvent(logistics::TransportID id)
+{
+    vle::devs::ExternalEvent* ee = new vle::devs::ExternalEvent("loaded");
+
+    ee << vle::devs::attribute("id", (int)id);
+    return ee;
+}
+
+/**
+ * The events Decision sends at time, as "port transport" items.
+ */
+std::string decisionOutput(const vle::devs::Dynamics& decision,
+                           const vle::devs::Time& time)
+{
+    vle::devs::ExternalEventList output;
+    std::ostringstream str;
+
+    decision.output(time, output);
+    for (vle::devs::ExternalEventList::const_iterator it = output.begin();
+         it != output.end(); ++it) {
+        str << (it == output.begin() ? "" : ", ") << (*it)->getPortName()
+            << " ";
+        if ((*it)->onPort("load")) {
+            str << dynamic_cast < const logistics::TransportPayload& >(
+                (*it)->getAttributeValue("transport")).handle()->id();
+        } else {
+            str << (*it)->getIntegerAttributeValue("id");
+        }
+    }
+    output.deleteAndClear();
+    return str.str();
+}
+
+BOOST_AUTO_TEST_CASE(decision_departures)
+{
+    vle::graph::CoupledModel root("root", 0);
+    vle::graph::AtomicModel model("Decision", &root);
+    vle::utils::PackageId package;
+    vle::devs::InitEventList conditions;
+
+    conditions.addString("log-level", "quiet");
+
+    boost::scoped_ptr < vle::devs::Dynamics > decision(
+        makeNewDynamicsDecision(vle::devs::DynamicsInit(model, package),
+                                conditions));
+    vle::devs::ExternalEventList events;
+
+    BOOST_REQUIRE(decision->init(0.).isInfinity());
+
+    events.addEvent(transportEvent(1, 5.));
+    events.addEvent(transportEvent(2, 5.));
+    events.addEvent(transportEvent(3, 8.));
+    decision->externalTransition(events, 0.);
+    events.deleteAndClear();
+    BOOST_REQUIRE_EQUAL(decision->timeAdvance().getValue(), 5.);
+
+    // both transports due at 5 are sent to be loaded in the wake-up step
+    BOOST_REQUIRE_EQUAL(decisionOutput(*decision, 5.), "load 1, load 2");
+    decision->internalTransition(5.);
+    BOOST_REQUIRE_EQUAL(decision->timeAdvance().getValue(), 3.);
+
+    // a transport loaded at the same date departs after a zero step
+    events.addEvent(loadedEvent(1));
+    decision->externalTransition(events, 5.);
+    events.deleteAndClear();
+    BOOST_REQUIRE_EQUAL(decision->timeAdvance().getValue(), 0.);
+    BOOST_REQUIRE_EQUAL(decisionOutput(*decision, 5.), "depart 1");
+    decision->internalTransition(5.);
+    BOOST_REQUIRE_EQUAL(decision->timeAdvance().getValue(), 3.);
+
+    // a "loaded" event on a departure date: the load is sent by the
+    // wake-up step, the departure by the zero step after it
+    BOOST_REQUIRE_EQUAL(decisionOutput(*decision, 8.), "load 3");
+    events.addEvent(loadedEvent(2));
+    decision->confluentTransitions(8., events);
+    events.deleteAndClear();
+    BOOST_REQUIRE_EQUAL(decision->timeAdvance().getValue(), 0.);
+    BOOST_REQUIRE_EQUAL(decisionOutput(*decision, 8.), "depart 2");
+    decision->internalTransition(8.);
+    BOOST_REQUIRE(decision->timeAdvance().isInfinity());
+
+    // a transport past due is loaded at once, in the step that sends the
+    // departure of the transport loaded at the same date
+    events.addEvent(transportEvent(4, 7.));
+    events.addEvent(loadedEvent(3));
+    decision->externalTransition(events, 9.);
+    events.deleteAndClear();
+    BOOST_REQUIRE_EQUAL(decision->timeAdvance().getValue(), 0.);
+    BOOST_REQUIRE_EQUAL(decisionOutput(*decision, 9.), "load 4, depart 3");
+    decision->internalTransition(9.);
+    BOOST_REQUIRE(decision->timeAdvance().isInfinity());
+    BOOST_REQUIRE_EQUAL(decisionOutput(*decision, 9.), "");
+
+    // a wave used to take one IDLE -> SEND_LOAD -> IDLE cycle per
+    // transport, in arrival order whatever the date within tolerance:
+    // "load 13", "load 12", "load 11" over six transitions. It is now
+    // one step, by departure date, then in arrival order at equal dates
+    events.addEvent(transportEvent(13, 20. + 5e-6));
+    events.addEvent(transportEvent(12, 20.));
+    events.addEvent(transportEvent(11, 20.));
+    decision->externalTransition(events, 10.);
+    events.deleteAndClear();
+    BOOST_REQUIRE_EQUAL(decision->timeAdvance().getValue(), 10.);
+    BOOST_REQUIRE_EQUAL(decisionOutput(*decision, 20.),
+                        "load 12, load 11, load 13");
+    decision->internalTransition(20.);
+    BOOST_REQUIRE(decision->timeAdvance().isInfinity());
+}
+
+BOOST_AUTO_TEST_CASE(random_stream)
+{
+    logistics::RandomStream a;
+    logistics::RandomStream b;
+    int counts[4] = { 0, 0, 0, 0 };
+
+    a.seed(42);
+    b.seed(42);
+    for (unsigned int i = 0; i < 4000; ++i) {
+        int value = a.getInt(0, 3);
+
+        BOOST_REQUIRE_EQUAL(value, b.getInt(0, 3));
+        BOOST_REQUIRE(value >= 0 and value <= 3);
+        ++counts[value];
+
+        double date = a.getDouble(20., 100.);
+
+        BOOST_REQUIRE_EQUAL(date, b.getDouble(20., 100.));
+        BOOST_REQUIRE(date >= 20. and date < 100.);
+    }
+    for (unsigned int i = 0; i < 4; ++i) {
+        BOOST_REQUIRE(counts[i] > 900 and counts[i] < 1100);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(checkpoint_round_trip)
+{
+    std::string path = "checkpoint_round_trip.checkpoint";
+    vle::graph::CoupledModel root("root", 0);
+    vle::graph::CoupledModel platform("Platform2", &root);
+    vle::graph::AtomicModel model("ZoneTransit", &platform);
+    logistics::LocationID a = logistics::Locations::id("A");
+    logistics::LocationID b = logistics::Locations::id("B");
+    logistics::RandomStream random;
+
+    BOOST_REQUIRE_EQUAL(logistics::Checkpoint::key(model),
+                        "Platform2:ZoneTransit");
+    random.seed(7);
+    random.uniform();
+
+    {
+        logistics::Checkpoint checkpoint;
+        logistics::CheckpointWriter out(checkpoint, model);
+        logistics::WaitingContainers containers;
+        logistics::Transport transport(3, logistics::BOAT, 2, b,
+                                       logistics::NOFOOD, 12.5);
+
+        for (unsigned int i = 0; i < 3; ++i) {
+            containers.add(new logistics::Container(
+                               i, a, i == 1 ? a : b, logistics::FOOD,
+                               10. - i));
+        }
+        // the last row moves into the first
+        delete containers.take(0);
+        containers.save(out);
+        transport.save(out);
+        random.save(out);
+        checkpoint.sequences(3, 4);
+        checkpoint.date(20.25);
+        checkpoint.save(path);
+        while (logistics::Container* container = containers.pop()) {
+            delete container;
+        }
+    }
+
+    logistics::Checkpoint checkpoint(path);
+    logistics::CheckpointReader in(checkpoint, model);
+    logistics::ObjectPool pool("containers", sizeof(logistics::Container));
+    logistics::WaitingContainers containers;
+
+    containers.restore(in, pool);
+
+    logistics::Transport transport(in);
+    logistics::RandomStream restored;
+
+    restored.restore(in);
+    BOOST_REQUIRE_EQUAL(checkpoint.containerID(), 3u);
+    BOOST_REQUIRE_EQUAL(checkpoint.transportID(), 4u);
+    BOOST_REQUIRE_EQUAL(checkpoint.date(), 20.25);
+    BOOST_REQUIRE_EQUAL(containers.size(), 2u);
+    // restored in arrival order, whatever the rows were
+    BOOST_REQUIRE_EQUAL(containers.container(0)->id(), 1u);
+    BOOST_REQUIRE_EQUAL(containers.container(1)->id(), 2u);
+    BOOST_REQUIRE_EQUAL(containers.container(0)->destination(), a);
+    BOOST_REQUIRE_EQUAL(transport.id(), 3u);
+    BOOST_REQUIRE_EQUAL(transport.destination(), b);
+    BOOST_REQUIRE_EQUAL(transport.departureDate().getValue(), 12.5);
+    for (unsigned int i = 0; i < 1000; ++i) {
+        BOOST_REQUIRE_EQUAL(restored.uniform(), random.uniform());
+    }
+    BOOST_REQUIRE_THROW(logistics::CheckpointReader(
+                            checkpoint, platform), vle::utils::ModellingError);
+
+    // a restored run begins at the date of the checkpoint
+    vle::devs::InitEventList events;
+
+    events.addString("restore", path);
+
+    logistics::Simulation& simulation =
+        logistics::Simulation::acquire(model, events);
+
+    BOOST_REQUIRE_THROW(simulation.restored(20.), vle::utils::ModellingError);
+    BOOST_REQUIRE(simulation.restored(20.25));
+    logistics::Simulation::release(simulation);
+    while (logistics::Container* container = containers.pop()) {
+        delete container;
+    }
+    std::remove(path.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(checkpoint_foreign_values)
+{
+    vle::graph::CoupledModel root("root", 0);
+    vle::graph::AtomicModel model("Dispatch", &root);
+    vle::devs::InitEventList events;
+    logistics::Simulation& simulation =
+        logistics::Simulation::acquire(model, events);
+    logistics::Logger log("Dispatch", events);
+    logistics::Checkpoint checkpoint;
+
+    {
+        logistics::CheckpointWriter out(checkpoint, model);
+        vle::devs::ExternalEvent event("container");
+        vle::value::Map* container = vle::value::Map::create();
+        vle::value::Set* path = vle::value::Set::create();
+
+        path->addString("Platform2");
+        path->addInt(3);
+        container->addString("Destination", "Platform3");
+        container->addDouble("Exigibility", 12.5);
+        container->add("Path", path);
+        event.putAttribute("container", container);
+        event.putAttribute("batch", vle::value::Boolean::create(true));
+        logistics::saveEvent(out, event, log, 0.);
+    }
+
+    logistics::CheckpointReader in(checkpoint, model);
+    boost::scoped_ptr < vle::devs::ExternalEvent > event(
+        logistics::restoreEvent(in, simulation));
+    const vle::value::Map& container =
+        vle::value::toMapValue(event->getAttributeValue("container"));
+    const vle::value::Set& path =
+        vle::value::toSetValue(*container.get("Path"));
+
+    BOOST_REQUIRE_EQUAL(event->getPortName(), "container");
+    BOOST_REQUIRE(vle::value::toBoolean(event->getAttributeValue("batch")));
+    BOOST_REQUIRE_EQUAL(vle::value::toString(container.get("Destination")),
+                        "Platform3");
+    BOOST_REQUIRE_EQUAL(vle::value::toDouble(container.get("Exigibility")),
+                        12.5);
+    BOOST_REQUIRE_EQUAL(path.size(), 2u);
+    BOOST_REQUIRE_EQUAL(vle::value::toString(path.get(0)), "Platform2");
+    BOOST_REQUIRE_EQUAL(vle::value::toInteger(path.get(1)), 3);
+    logistics::Simulation::release(simulation);
+}
+
+BOOST_AUTO_TEST_CASE(columnar_round_trip)
+{
+    std::string path = "columnar_round_trip.col";
+    const unsigned int n = logistics::COLUMNAR_CHUNK_SIZE + 10;
+
+    {
+        logistics::ColumnarWriter writer(path);
+        boost::uint32_t size = writer.column("Platform1:A.size");
+        boost::uint32_t delay = writer.column("Platform1:A.delay");
+
+        BOOST_REQUIRE_EQUAL(writer.column("Platform1:A.size"), size);
+        for (unsigned int i = 0; i < n; ++i) {
+            writer.add(size, i * .5, i % 7);
+        }
+
+        // the full chunk is readable before the writer is closed
+        logistics::ColumnarReader early(path);
+
+        BOOST_REQUIRE_EQUAL(early.chunks(0), 1u);
+        BOOST_REQUIRE_EQUAL(early.size(0), logistics::COLUMNAR_CHUNK_SIZE);
+
+        writer.add(delay, 3., -1.25);
+        writer.close();
+    }
+
+    logistics::ColumnarReader reader(path);
+    std::vector < double > dates, values;
+
+    BOOST_REQUIRE_EQUAL(reader.columns().size(), 2u);
+    BOOST_REQUIRE_EQUAL(reader.find("Platform1:A.delay"), 1u);
+    BOOST_REQUIRE_EQUAL(reader.find("B.size"), 2u);
+    BOOST_REQUIRE_EQUAL(reader.chunks(0), 2u);
+    BOOST_REQUIRE_EQUAL(reader.size(0), n);
+    reader.series(0, dates, values);
+    BOOST_REQUIRE_EQUAL(dates.size(), n);
+    for (unsigned int i = 0; i < n; ++i) {
+        BOOST_REQUIRE_EQUAL(dates[i], i * .5);
+        BOOST_REQUIRE_EQUAL(values[i], i % 7);
+    }
+    dates.clear();
+    values.clear();
+    reader.chunk(1, 0, dates, values);
+    BOOST_REQUIRE_EQUAL(dates.size(), 1u);
+    BOOST_REQUIRE_EQUAL(values[0], -1.25);
+    std::remove(path.c_str());
+}
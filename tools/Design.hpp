@@ -0,0 +1,246 @@
+/**
+ * @file Design.hpp
+ * @author The VLE Development Team
+ * See the AUTHORS or Authors.txt file
+ */
+
+/*
+ * Copyright (C) 2012 ULCO http://www.univ-littoral.fr
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DESIGN_HPP
+#define DESIGN_HPP 1
+
+#include <vle/utils/Exception.hpp>
+#include <vle/utils/Rand.hpp>
+#include <boost/cstdint.hpp>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace logistics {
+
+/**
+ * One swept condition port, between min and max.
+ */
+struct Factor
+{
+    std::string condition;
+    std::string port;
+    double min;
+    double max;
+
+    double value(double u) const
+    { return min + u * (max - min); }
+};
+
+typedef std::vector < Factor > Factors;
+
+/**
+ * Points of the unit hypercube, one coordinate per factor.
+ */
+typedef std::vector < std::vector < double > > Points;
+
+/**
+ * Factors file: one "condition port min max" line per factor; empty
+ * lines and lines starting with # are skipped.
+ */
+inline Factors readFactors(const std::string& path)
+{
+    std::ifstream file(path.c_str());
+    std::string line;
+    Factors factors;
+
+    if (not file) {
+        throw vle::utils::FileError("cannot open " + path);
+    }
+    while (std::getline(file, line)) {
+        std::istringstream in(line);
+        Factor factor;
+
+        if (line.empty() or line[0] == '#') {
+            continue;
+        }
+        if (not (in >> factor.condition >> factor.port >> factor.min
+                 >> factor.max)) {
+            throw vle::utils::ArgError(path + ": bad factor line " + line);
+        }
+        factors.push_back(factor);
+    }
+    return factors;
+}
+
+/**
+ * Full factorial design, levels equally spaced values per factor.
+ */
+inline Points gridDesign(unsigned int factors, unsigned int levels)
+{
+    Points points;
+    std::vector < unsigned int > index(factors, 0);
+
+    if (levels == 0) {
+        return points;
+    }
+    for (;;) {
+        std::vector < double > point(factors);
+
+        for (unsigned int f = 0; f < factors; ++f) {
+            point[f] = levels > 1 ? (double)index[f] / (levels - 1) : .5;
+        }
+        points.push_back(point);
+
+        unsigned int f = 0;
+
+        while (f < factors and ++index[f] == levels) {
+            index[f++] = 0;
+        }
+        if (f == factors) {
+            return points;
+        }
+    }
+}
+
+/**
+ * Latin hypercube of size points: each factor takes one value in each of
+ * the size strata of its range.
+ */
+inline Points latinHypercubeDesign(unsigned int factors, unsigned int size,
+                                   boost::uint32_t seed)
+{
+    vle::utils::Rand rand(seed);
+    Points points(size, std::vector < double >(factors));
+
+    for (unsigned int f = 0; f < factors; ++f) {
+        std::vector < unsigned int > strata(size);
+
+        for (unsigned int i = 0; i < size; ++i) {
+            strata[i] = i;
+        }
+        for (unsigned int i = size; i > 1; --i) {
+            std::swap(strata[i - 1], strata[rand.getInt(0, i - 1)]);
+        }
+        for (unsigned int i = 0; i < size; ++i) {
+            points[i][f] = (strata[i] + rand.getDouble(0., 1.)) / size;
+        }
+    }
+    return points;
+}
+
+/**
+ * Sobol sequence, with the direction numbers of Joe and Kuo
+ * (new-joe-kuo-6.21201) for the first DIMENSIONS dimensions.
+ * Points are produced in Gray code order; any first 2^k of them form a
+ * (t, k, s)-net.
+ */
+class Sobol
+{
+public:
+    enum { BITS = 32, DIMENSIONS = 16 };
+
+    Sobol(unsigned int dimensions) :
+        mDirections(dimensions, std::vector < boost::uint32_t >(BITS)),
+        mState(dimensions, 0), mIndex(0)
+    {
+        // s, a, m_1 ... m_s of the dimensions after the first
+        static const unsigned int table[DIMENSIONS - 1][8] = {
+            { 1, 0, 1 },
+            { 2, 1, 1, 3 },
+            { 3, 1, 1, 3, 1 },
+            { 3, 2, 1, 1, 1 },
+            { 4, 1, 1, 1, 3, 3 },
+            { 4, 4, 1, 3, 5, 13 },
+            { 5, 2, 1, 1, 5, 5, 17 },
+            { 5, 4, 1, 1, 5, 5, 5 },
+            { 5, 7, 1, 1, 7, 11, 19 },
+            { 5, 11, 1, 1, 5, 1, 1 },
+            { 5, 13, 1, 1, 1, 3, 11 },
+            { 5, 14, 1, 3, 5, 5, 31 },
+            { 6, 1, 1, 3, 3, 9, 7, 49 },
+            { 6, 13, 1, 1, 1, 15, 21, 21 },
+            { 6, 16, 1, 3, 1, 13, 27, 49 } };
+
+        if (dimensions > DIMENSIONS) {
+            std::ostringstream message;
+
+            message << "Sobol design limited to " << DIMENSIONS
+                    << " factors";
+            throw vle::utils::ArgError(message.str());
+        }
+        for (unsigned int b = 0; b < BITS; ++b) {
+            mDirections[0][b] = 1u << (BITS - 1 - b);
+        }
+        for (unsigned int d = 1; d < dimensions; ++d) {
+            const unsigned int* row = table[d - 1];
+            unsigned int s = row[0];
+            unsigned int a = row[1];
+            std::vector < boost::uint32_t >& v = mDirections[d];
+
+            for (unsigned int b = 0; b < s; ++b) {
+                v[b] = row[2 + b] << (BITS - 1 - b);
+            }
+            for (unsigned int b = s; b < BITS; ++b) {
+                v[b] = v[b - s] ^ (v[b - s] >> s);
+                for (unsigned int k = 1; k < s; ++k) {
+                    v[b] ^= ((a >> (s - 1 - k)) & 1) * v[b - k];
+                }
+            }
+        }
+    }
+
+    std::vector < double > next()
+    {
+        std::vector < double > point(mState.size());
+
+        for (unsigned int d = 0; d < mState.size(); ++d) {
+            point[d] = mState[d] * (1. / 4294967296.);
+        }
+
+        // the next point differs in the direction of the lowest zero bit
+        // of the index
+        unsigned int c = 0;
+
+        for (boost::uint32_t i = mIndex; i & 1; i >>= 1) {
+            ++c;
+        }
+        for (unsigned int d = 0; d < mState.size(); ++d) {
+            mState[d] ^= mDirections[d][c];
+        }
+        ++mIndex;
+        return point;
+    }
+
+private:
+    std::vector < std::vector < boost::uint32_t > > mDirections;
+    std::vector < boost::uint32_t > mState;
+    boost::uint32_t mIndex;
+};
+
+inline Points sobolDesign(unsigned int factors, unsigned int size)
+{
+    Sobol sobol(factors);
+    Points points;
+
+    for (unsigned int i = 0; i < size; ++i) {
+        points.push_back(sobol.next());
+    }
+    return points;
+}
+
+} // namespace logistics
+
+#endif
@@ -0,0 +1,88 @@
+/**
+ * @file Experiment.hpp
+ * @author The VLE Development Team
+ * See the AUTHORS or Authors.txt file
+ */
+
+/*
+ * Copyright (C) 2012 ULCO http://www.univ-littoral.fr
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef EXPERIMENT_HPP
+#define EXPERIMENT_HPP 1
+
+#include <vle/manager/Run.hpp>
+#include <vle/vpz/Vpz.hpp>
+#include <boost/filesystem.hpp>
+#include <algorithm>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace logistics {
+
+/**
+ * Run experiment, a copy of a parsed vpz that the caller owns, with its
+ * views written by their plugin into directory. Several copies can run
+ * at once, on different threads. Returns false if the simulation
+ * failed.
+ */
+inline bool runExperiment(vle::vpz::Vpz& experiment,
+                          const boost::filesystem::path& directory)
+{
+    vle::vpz::Outputs::OutputList& outputs =
+        experiment.project().experiment().views().outputs().outputlist();
+    vle::manager::RunQuiet run;
+
+    boost::filesystem::create_directories(directory);
+    for (vle::vpz::Outputs::OutputList::iterator it = outputs.begin();
+         it != outputs.end(); ++it) {
+        it->second.setLocalStream(directory.string(), it->second.plugin());
+    }
+    run.start(experiment);
+    return not run.haveError();
+}
+
+/**
+ * View files written by runExperiment, sorted by name.
+ */
+inline std::vector < boost::filesystem::path > viewFiles(
+    const boost::filesystem::path& directory)
+{
+    std::vector < boost::filesystem::path > views;
+
+    if (boost::filesystem::exists(directory)) {
+        std::copy(boost::filesystem::directory_iterator(directory),
+                  boost::filesystem::directory_iterator(),
+                  std::back_inserter(views));
+        std::sort(views.begin(), views.end());
+    }
+    return views;
+}
+
+/**
+ * Separator of the columns of a view file, found in its header line.
+ */
+inline char viewSeparator(const std::string& header)
+{
+    std::size_t found = header.find_first_of(";,\t ");
+
+    return found == std::string::npos ? '\t' : header[found];
+}
+
+} // namespace logistics
+
+#endif
@@ -0,0 +1,512 @@
+/**
+ * @file Scenario.hpp
+ * @author The VLE Development Team
+ * See the AUTHORS or Authors.txt file
+ */
+
+/*
+ * Copyright (C) 2012 ULCO http://www.univ-littoral.fr
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SCENARIO_HPP
+#define SCENARIO_HPP 1
+
+#include <vle/utils/Exception.hpp>
+#include <algorithm>
+#include <fstream>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace logistics {
+
+/**
+ * Experiment with N platforms, each built as Platforme1 of
+ * exp/example1.vpz: an EntryDispatch sorting the arriving transports to
+ * the boat and truck quays (Split), a Transit coupled model (Dispatch and
+ * a food and a non-food transit zone) and a Decision fed by a generator
+ * of empty trucks. The platforms form a ring: the trucks leaving
+ * platform i go, through its Move, to one of the next routes() platforms
+ * or to Exit, which only sorts them and lets the network drain.
+ *
+ * Each platform receives intensity() transports per time unit, boats and
+ * trucks in equal shares, each carrying capacity() containers. Since a
+ * platform also receives the trucks of its neighbours, the empty trucks
+ * are generated at (routes() + 1) * 1.25 times that rate, so that the
+ * queues stay bounded.
+ */
+class Scenario
+{
+public:
+    Scenario(unsigned int platforms) :
+        mPlatforms(platforms), mRoutes(2), mIntensity(1.), mCapacity(2),
+        mDuration(200.), mSeed(545404204), mTimestep(0.)
+    {
+        if (platforms < 2) {
+            throw vle::utils::ArgError("a scenario needs two platforms");
+        }
+    }
+
+    unsigned int platforms() const
+    { return mPlatforms; }
+
+    /**
+     * Number of platforms a platform sends its trucks to, at most
+     * platforms() - 1.
+     */
+    unsigned int routes() const
+    { return std::min(mRoutes, mPlatforms - 1); }
+
+    void routes(unsigned int routes)
+    { mRoutes = std::max(1u, routes); }
+
+    double intensity() const
+    { return mIntensity; }
+
+    void intensity(double intensity)
+    {
+        if (not (intensity > 0)) {
+            throw vle::utils::ArgError("the intensity must be positive");
+        }
+        mIntensity = intensity;
+    }
+
+    unsigned int capacity() const
+    { return mCapacity; }
+
+    void capacity(unsigned int capacity)
+    { mCapacity = std::max(1u, capacity); }
+
+    double duration() const
+    { return mDuration; }
+
+    void duration(double duration)
+    { mDuration = duration; }
+
+    void seed(unsigned long seed)
+    { mSeed = seed; }
+
+    /**
+     * Time step of the transit and transport views; no view is written
+     * when it is not positive, the default.
+     */
+    void timestep(double timestep)
+    { mTimestep = timestep; }
+
+    static std::string platform(unsigned int i)
+    {
+        std::ostringstream name;
+
+        name << "Platform" << i + 1;
+        return name.str();
+    }
+
+    void save(const std::string& path) const
+    {
+        std::ofstream file(path.c_str());
+
+        write(file);
+        file.close();
+        if (not file) {
+            throw vle::utils::FileError("cannot write " + path);
+        }
+    }
+
+    void write(std::ostream& out) const
+    {
+        out.precision(15);
+        out << "<?xml version=\"1.0\" encoding=\"UTF-8\" ?>\n"
+            << "<!DOCTYPE vle_project PUBLIC \"-//VLE TEAM//DTD Strict//EN\" "
+            << "\"http://www.vle-project.org/vle-1.0.0.dtd\">\n"
+            << "<vle_project version=\"1.0.1\" date=\"\" author=\"\">\n"
+            << "<structures>\n"
+            << "<model name=\"Top model\" type=\"coupled\">\n"
+            << "<submodels>\n";
+        for (unsigned int i = 0; i < mPlatforms; ++i) {
+            platformModels(out, i);
+        }
+        exitModel(out);
+        out << "</submodels>\n<connections>\n";
+        for (unsigned int i = 0; i < mPlatforms; ++i) {
+            platformConnections(out, i);
+        }
+        out << "</connections>\n</model>\n</structures>\n";
+        dynamics(out);
+        experiment(out);
+        out << "</vle_project>\n";
+    }
+
+private:
+    typedef std::vector < std::string > Ports;
+
+    static Ports ports(const char* a = 0, const char* b = 0,
+                       const char* c = 0)
+    {
+        Ports ports;
+
+        if (a) ports.push_back(a);
+        if (b) ports.push_back(b);
+        if (c) ports.push_back(c);
+        return ports;
+    }
+
+    static void portList(std::ostream& out, const char* tag,
+                         const Ports& ports)
+    {
+        if (not ports.empty()) {
+            out << "<" << tag << ">\n";
+            for (Ports::const_iterator it = ports.begin(); it != ports.end();
+                 ++it) {
+                out << " <port name=\"" << *it << "\" />\n";
+            }
+            out << "</" << tag << ">\n";
+        }
+    }
+
+    static void atomic(std::ostream& out, const std::string& name,
+                       const std::string& dynamics,
+                       const std::string& conditions,
+                       const std::string& observables,
+                       const Ports& in, const Ports& output)
+    {
+        out << "<model name=\"" << name << "\" type=\"atomic\"";
+        if (not conditions.empty()) {
+            out << " conditions=\"" << conditions << "\"";
+        }
+        out << " dynamics=\"" << dynamics << "\"";
+        if (not observables.empty()) {
+            out << " observables=\"" << observables << "\"";
+        }
+        out << ">\n";
+        portList(out, "in", in);
+        portList(out, "out", output);
+        out << "</model>\n";
+    }
+
+    static void connection(std::ostream& out, const char* type,
+                           const std::string& origin, const char* from,
+                           const std::string& destination, const char* to)
+    {
+        out << "<connection type=\"" << type << "\">\n"
+            << " <origin model=\"" << origin << "\" port=\"" << from
+            << "\" />\n"
+            << " <destination model=\"" << destination << "\" port=\""
+            << to << "\" />\n"
+            << "</connection>\n";
+    }
+
+    std::vector < std::string > destinations(unsigned int i) const
+    {
+        std::vector < std::string > names;
+
+        for (unsigned int r = 1; r <= routes(); ++r) {
+            names.push_back(platform((i + r) % mPlatforms));
+        }
+        names.push_back("Exit");
+        return names;
+    }
+
+    std::string observables(const char* name) const
+    { return mTimestep > 0 ? name : ""; }
+
+    void transit(std::ostream& out) const
+    {
+        const char* dispatched[] = { "container_Food", "container_NoFood",
+                                     "depart_Food", "depart_NoFood",
+                                     "load_Food", "load_NoFood" };
+
+        out << "<model name=\"Transit\" type=\"coupled\">\n";
+        portList(out, "in", ports("depart", "in", "load"));
+        portList(out, "out", ports("loaded", "out"));
+        out << "<submodels>\n";
+        atomic(out, "Dispatch", "dyn_dispatch", "", "",
+               ports("container", "depart", "load"),
+               Ports(dispatched, dispatched + 6));
+        atomic(out, "ZoneTransitFood", "dyn_transit", "",
+               observables("obs_transit"),
+               ports("container", "depart", "load"),
+               ports("loaded", "out"));
+        atomic(out, "ZoneTransitNoFood", "dyn_transit", "",
+               observables("obs_transit"),
+               ports("container", "depart", "load"),
+               ports("loaded", "out"));
+        out << "</submodels>\n<connections>\n";
+        connection(out, "output", "ZoneTransitFood", "loaded",
+                   "Transit", "loaded");
+        connection(out, "output", "ZoneTransitNoFood", "loaded",
+                   "Transit", "loaded");
+        connection(out, "output", "ZoneTransitFood", "out", "Transit", "out");
+        connection(out, "output", "ZoneTransitNoFood", "out",
+                   "Transit", "out");
+        connection(out, "input", "Transit", "depart", "Dispatch", "depart");
+        connection(out, "input", "Transit", "in", "Dispatch", "container");
+        connection(out, "input", "Transit", "load", "Dispatch", "load");
+        connection(out, "internal", "Dispatch", "container_Food",
+                   "ZoneTransitFood", "container");
+        connection(out, "internal", "Dispatch", "container_NoFood",
+                   "ZoneTransitNoFood", "container");
+        connection(out, "internal", "Dispatch", "depart_Food",
+                   "ZoneTransitFood", "depart");
+        connection(out, "internal", "Dispatch", "depart_NoFood",
+                   "ZoneTransitNoFood", "depart");
+        connection(out, "internal", "Dispatch", "load_Food",
+                   "ZoneTransitFood", "load");
+        connection(out, "internal", "Dispatch", "load_NoFood",
+                   "ZoneTransitNoFood", "load");
+        out << "</connections>\n</model>\n";
+    }
+
+    void platformModels(std::ostream& out, unsigned int i) const
+    {
+        std::string name = platform(i);
+        std::vector < std::string > routes = destinations(i);
+
+        atomic(out, "Boats" + name, "dyn_transport_generator",
+               "cond_arrival,cond_arrival_boats", "", Ports(),
+               ports("out"));
+        atomic(out, "Trucks" + name, "dyn_transport_generator",
+               "cond_arrival,cond_arrival_trucks", "", Ports(),
+               ports("out"));
+        atomic(out, "Transport" + name, "dyn_transport_generator",
+               "cond_transport_" + name, "", Ports(), ports("out"));
+
+        out << "<model name=\"Move" + name + "\" type=\"atomic\" "
+            << "dynamics=\"dyn_move\">\n";
+        portList(out, "in", ports("in"));
+        out << "<out>\n";
+        for (unsigned int r = 0; r < routes.size(); ++r) {
+            out << " <port name=\"to_" << routes[r] << "\" />\n";
+        }
+        out << "</out>\n</model>\n";
+
+        out << "<model name=\"" << name << "\" type=\"coupled\">\n";
+        portList(out, "in", ports("in", "transport"));
+        portList(out, "out", ports("out"));
+        out << "<submodels>\n";
+        atomic(out, "Decision", "dyn_decision", "",
+               observables("obs_transport"), ports("loaded", "transport"),
+               ports("depart", "load"));
+        atomic(out, "Dispatch1", "dyn_entry_dispatch", "", "", ports("in"),
+               ports("boat", "train", "truck"));
+        atomic(out, "QuaisBateaux", "dyn_split", "", "", ports("in"),
+               ports("out"));
+        atomic(out, "QuaisCamions", "dyn_split", "", "", ports("in"),
+               ports("out"));
+        transit(out);
+        out << "</submodels>\n<connections>\n";
+        connection(out, "output", "Transit", "out", name, "out");
+        connection(out, "input", name, "in", "Dispatch1", "in");
+        connection(out, "input", name, "transport", "Decision", "transport");
+        connection(out, "internal", "Decision", "depart", "Transit",
+                   "depart");
+        connection(out, "internal", "Decision", "load", "Transit", "load");
+        connection(out, "internal", "Dispatch1", "boat", "QuaisBateaux",
+                   "in");
+        connection(out, "internal", "Dispatch1", "truck", "QuaisCamions",
+                   "in");
+        connection(out, "internal", "QuaisBateaux", "out", "Transit", "in");
+        connection(out, "internal", "QuaisCamions", "out", "Transit", "in");
+        connection(out, "internal", "Transit", "loaded", "Decision",
+                   "loaded");
+        out << "</connections>\n</model>\n";
+    }
+
+    void exitModel(std::ostream& out) const
+    {
+        out << "<model name=\"Exit\" type=\"coupled\">\n";
+        portList(out, "in", ports("in"));
+        out << "<submodels>\n";
+        atomic(out, "DispatchExit", "dyn_entry_dispatch", "", "",
+               ports("in"), ports("boat", "train", "truck"));
+        out << "</submodels>\n<connections>\n";
+        connection(out, "input", "Exit", "in", "DispatchExit", "in");
+        out << "</connections>\n</model>\n";
+    }
+
+    void platformConnections(std::ostream& out, unsigned int i) const
+    {
+        std::string name = platform(i);
+        std::vector < std::string > routes = destinations(i);
+
+        connection(out, "internal", "Boats" + name, "out", name, "in");
+        connection(out, "internal", "Trucks" + name, "out", name, "in");
+        connection(out, "internal", "Transport" + name, "out", name,
+                   "transport");
+        connection(out, "internal", name, "out", "Move" + name, "in");
+        for (unsigned int r = 0; r < routes.size(); ++r) {
+            connection(out, "internal", "Move" + name,
+                       ("to_" + routes[r]).c_str(), routes[r], "in");
+        }
+    }
+
+    void dynamics(std::ostream& out) const
+    {
+        const char* dynamics[][2] = {
+            { "dyn_decision", "Decision" },
+            { "dyn_dispatch", "Dispatch" },
+            { "dyn_entry_dispatch", "EntryDispatch" },
+            { "dyn_move", "Move" },
+            { "dyn_split", "Split" },
+            { "dyn_transit", "Transit" },
+            { "dyn_transport_generator", "TransportGenerator" } };
+
+        out << "<dynamics>\n";
+        for (unsigned int i = 0; i < 7; ++i) {
+            out << "<dynamic name=\"" << dynamics[i][0] << "\" "
+                << "library=\"logistics\" model=\"" << dynamics[i][1]
+                << "\" package=\"logistics\" type=\"local\" />\n";
+        }
+        out << "</dynamics>\n";
+    }
+
+    static void port(std::ostream& out, const char* name, double value)
+    {
+        out << " <port name=\"" << name << "\" >\n<double>" << value
+            << "</double>\n</port>\n";
+    }
+
+    static void port(std::ostream& out, const char* name, int value)
+    {
+        out << " <port name=\"" << name << "\" >\n<integer>" << value
+            << "</integer>\n</port>\n";
+    }
+
+    static void port(std::ostream& out, const char* name, bool value)
+    {
+        out << " <port name=\"" << name << "\" >\n<boolean>"
+            << (value ? "true" : "false") << "</boolean>\n</port>\n";
+    }
+
+    static void port(std::ostream& out, const char* name,
+                     const std::vector < std::string >& values)
+    {
+        out << " <port name=\"" << name << "\" >\n<set>";
+        for (std::vector < std::string >::const_iterator it = values.begin();
+             it != values.end(); ++it) {
+            out << "<string>" << *it << "</string>";
+        }
+        out << "</set>\n</port>\n";
+    }
+
+    void conditions(std::ostream& out) const
+    {
+        std::vector < std::string > platforms;
+        // boats and trucks arrive each at half the intensity, the empty
+        // trucks at the rate that keeps the platforms from filling up
+        double arrival = 2. / mIntensity;
+        double departure = 1. / (1.25 * (routes() + 1) * mIntensity);
+
+        for (unsigned int i = 0; i < mPlatforms; ++i) {
+            platforms.push_back(platform(i));
+        }
+
+        out << "<conditions>\n<condition name=\"cond_arrival\" >\n";
+        port(out, "ContainerPresent", true);
+        port(out, "Destinations", platforms);
+        port(out, "MinCapacity", (int)mCapacity);
+        port(out, "MaxCapacity", (int)mCapacity);
+        port(out, "MinSize", (int)mCapacity);
+        port(out, "MinDuration", arrival / 2);
+        port(out, "MaxDuration", arrival * 3 / 2);
+        port(out, "MinStayDuration", 2.);
+        port(out, "MaxStayDuration", 2.);
+        port(out, "MinTravelDuration", 20.);
+        port(out, "MaxTravelDuration", 100.);
+        out << "</condition>\n<condition name=\"cond_arrival_boats\" >\n";
+        port(out, "TransportType", 0);
+        out << "</condition>\n<condition name=\"cond_arrival_trucks\" >\n";
+        port(out, "TransportType", 1);
+        out << "</condition>\n";
+        for (unsigned int i = 0; i < mPlatforms; ++i) {
+            out << "<condition name=\"cond_transport_" << platform(i)
+                << "\" >\n";
+            port(out, "ContainerPresent", false);
+            port(out, "Destinations", destinations(i));
+            port(out, "TransportType", 1);
+            port(out, "MinCapacity", (int)mCapacity);
+            port(out, "MaxCapacity", (int)mCapacity);
+            port(out, "MinDuration", departure / 2);
+            port(out, "MaxDuration", departure * 3 / 2);
+            port(out, "MinStayDuration", 10.);
+            port(out, "MaxStayDuration", 10.);
+            out << "</condition>\n";
+        }
+        out << "</conditions>\n";
+    }
+
+    void views(std::ostream& out) const
+    {
+        const char* transit[] = { "size", "time-in-transit",
+                                  "transport-lateness", "waiting" };
+        const char* transport[] = { "size", "wait" };
+
+        if (mTimestep <= 0) {
+            out << "<views>\n<outputs />\n<observables />\n</views>\n";
+            return;
+        }
+        out << "<views>\n<outputs>\n";
+        for (unsigned int i = 0; i < 2; ++i) {
+            out << "<output name=\"view_" << (i ? "transport" : "transit")
+                << "\" location=\"\" format=\"local\" plugin=\"file\" >\n"
+                << "<map><key name=\"julian-day\"><boolean>false</boolean>"
+                << "</key><key name=\"locale\"><string>C</string></key>"
+                << "<key name=\"type\"><string>text</string></key></map>"
+                << "</output>\n";
+        }
+        out << "</outputs>\n<observables>\n"
+            << "<observable name=\"obs_transit\" >\n";
+        for (unsigned int i = 0; i < 4; ++i) {
+            out << "<port name=\"" << transit[i] << "\" >\n"
+                << " <attachedview name=\"view_transit\" />\n</port>\n";
+        }
+        out << "</observable>\n<observable name=\"obs_transport\" >\n";
+        for (unsigned int i = 0; i < 2; ++i) {
+            out << "<port name=\"" << transport[i] << "\" >\n"
+                << " <attachedview name=\"view_transport\" />\n</port>\n";
+        }
+        out << "</observable>\n</observables>\n";
+        for (unsigned int i = 0; i < 2; ++i) {
+            const char* name = i ? "view_transport" : "view_transit";
+
+            out << "<view name=\"" << name << "\" output=\"" << name
+                << "\" type=\"timed\" timestep=\"" << mTimestep << "\" />\n";
+        }
+        out << "</views>\n";
+    }
+
+    void experiment(std::ostream& out) const
+    {
+        out << "<experiment name=\"scenario\" duration=\"" << mDuration
+            << "\" begin=\"0\" combination=\"linear\" seed=\"" << mSeed
+            << "\" >\n";
+        conditions(out);
+        views(out);
+        out << "</experiment>\n";
+    }
+
+    unsigned int mPlatforms;
+    unsigned int mRoutes;
+    double mIntensity;
+    unsigned int mCapacity;
+    double mDuration;
+    unsigned long mSeed;
+    double mTimestep;
+};
+
+} // namespace logistics
+
+#endif
@@ -0,0 +1,80 @@
+/**
+ * @file colcat.cpp
+ * @author The VLE Development Team
+ * See the AUTHORS or Authors.txt file
+ */
+
+/*
+ * Copyright (C) 2012 ULCO http://www.univ-littoral.fr
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Prints the content of a columnar output file (see Columnar.hpp):
+ *
+ *   colcat output.col [column ...]
+ *
+ * Without columns, lists the columns of the file with their number of
+ * values. Otherwise prints, one chunk at a time, a "column date value"
+ * line, tab separated, for each value of the given columns.
+ */
+
+#include <Columnar.hpp>
+#include <iostream>
+
+using namespace logistics;
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2) {
+        std::cerr << "usage: " << argv[0] << " output.col [column ...]"
+                  << std::endl;
+        return 2;
+    }
+
+    try {
+        ColumnarReader reader(argv[1]);
+        std::vector < double > dates, values;
+
+        std::cout.precision(17);
+        if (argc == 2) {
+            for (std::size_t c = 0; c < reader.columns().size(); ++c) {
+                std::cout << reader.columns()[c] << '\t' << reader.size(c)
+                          << '\n';
+            }
+        }
+        for (int i = 2; i < argc; ++i) {
+            std::size_t c = reader.find(argv[i]);
+
+            if (c == reader.columns().size()) {
+                throw vle::utils::ArgError(std::string(argv[1]) +
+                                           ": no column " + argv[i]);
+            }
+            for (std::size_t k = 0; k < reader.chunks(c); ++k) {
+                dates.clear();
+                values.clear();
+                reader.chunk(c, k, dates, values);
+                for (std::size_t j = 0; j < dates.size(); ++j) {
+                    std::cout << argv[i] << '\t' << dates[j] << '\t'
+                              << values[j] << '\n';
+                }
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
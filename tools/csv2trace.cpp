@@ -0,0 +1,241 @@
+/**
+ * @file csv2trace.cpp
+ * @author The VLE Development Team
+ * See the AUTHORS or Authors.txt file
+ */
+
+/*
+ * Copyright (C) 2012 ULCO http://www.univ-littoral.fr
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Converts an arrival manifest from CSV to the binary trace replayed by
+ * TransportGenerator (see Trace.hpp). Each transport line is followed by
+ * the lines of its containers, transports by nondecreasing arrival date:
+ *
+ *   T,arrival,id,type,capacity,destination,content,departure
+ *   C,id,source,destination,content,exigibility
+ *
+ * type is boat, truck or train, content FOOD or NOFOOD (or their enum
+ * values); locations are platform names. Empty lines and lines starting
+ * with # are skipped.
+ */
+
+#include <Trace.hpp>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+
+using namespace logistics;
+
+namespace {
+
+class Parser
+{
+public:
+    Parser(const std::string& input, TraceWriter& writer) :
+        mInput(input), mWriter(writer), mLine(0), mPending(false)
+    { }
+
+    void run()
+    {
+        std::ifstream file(mInput.c_str());
+        std::string line;
+
+        if (not file) {
+            throw vle::utils::FileError("cannot open " + mInput);
+        }
+        while (std::getline(file, line)) {
+            ++mLine;
+            if (not line.empty() and line[line.size() - 1] == '\r') {
+                line.erase(line.size() - 1);
+            }
+            if (line.empty() or line[0] == '#') {
+                continue;
+            }
+            split(line);
+            if (mFields[0] == "T") {
+                transport();
+            } else if (mFields[0] == "C") {
+                container();
+            } else {
+                error("unknown record " + mFields[0]);
+            }
+        }
+        flush();
+    }
+
+private:
+    void split(const std::string& line)
+    {
+        std::istringstream str(line);
+        std::string field;
+
+        mFields.clear();
+        while (std::getline(str, field, ',')) {
+            mFields.push_back(field);
+        }
+    }
+
+    void expect(std::size_t count)
+    {
+        if (mFields.size() != count) {
+            std::ostringstream message;
+
+            message << mFields[0] << " record with " << mFields.size()
+                    << " fields instead of " << count;
+            error(message.str());
+        }
+    }
+
+    double real(std::size_t field)
+    {
+        char* end;
+        double value = std::strtod(mFields[field].c_str(), &end);
+
+        if (mFields[field].empty() or *end) {
+            error("bad number " + mFields[field]);
+        }
+        return value;
+    }
+
+    boost::uint32_t integer(std::size_t field)
+    {
+        char* end;
+        unsigned long value = std::strtoul(mFields[field].c_str(), &end, 10);
+
+        if (mFields[field].empty() or *end) {
+            error("bad integer " + mFields[field]);
+        }
+        return value;
+    }
+
+    boost::uint8_t type(std::size_t field)
+    {
+        const std::string& value = mFields[field];
+
+        if (value == "boat" or value == "0") {
+            return BOAT;
+        } else if (value == "truck" or value == "1") {
+            return TRUCK;
+        } else if (value == "train" or value == "2") {
+            return TRAIN;
+        }
+        error("bad transport type " + value);
+        return 0;
+    }
+
+    boost::uint8_t content(std::size_t field)
+    {
+        const std::string& value = mFields[field];
+
+        if (value == "FOOD" or value == "0") {
+            return FOOD;
+        } else if (value == "NOFOOD" or value == "1") {
+            return NOFOOD;
+        }
+        error("bad content type " + value);
+        return 0;
+    }
+
+    void transport()
+    {
+        expect(8);
+        flush();
+        std::memset(&mTransport, 0, sizeof(TraceTransport));
+        mTransport.arrival = real(1);
+        mTransport.id = integer(2);
+        mTransport.type = type(3);
+        mTransport.capacity = integer(4);
+        mTransport.destination = mWriter.location(mFields[5]);
+        mTransport.content = content(6);
+        mTransport.departure = real(7);
+        mPending = true;
+    }
+
+    void container()
+    {
+        TraceContainer container;
+
+        expect(6);
+        if (not mPending) {
+            error("container before any transport");
+        }
+        std::memset(&container, 0, sizeof(TraceContainer));
+        container.id = integer(1);
+        container.source = mWriter.location(mFields[2]);
+        container.destination = mWriter.location(mFields[3]);
+        container.content = content(4);
+        container.exigibility = real(5);
+        mContainers.push_back(container);
+    }
+
+    void flush()
+    {
+        if (mPending) {
+            try {
+                mWriter.add(mTransport, mContainers);
+            } catch (const std::exception& e) {
+                error(e.what());
+            }
+            mContainers.clear();
+            mPending = false;
+        }
+    }
+
+    void error(const std::string& message)
+    {
+        std::ostringstream str;
+
+        str << mInput << ":" << mLine << ": " << message;
+        throw vle::utils::ArgError(str.str());
+    }
+
+    std::string mInput;
+    TraceWriter& mWriter;
+    unsigned long mLine;
+    std::vector < std::string > mFields;
+    TraceTransport mTransport;
+    std::vector < TraceContainer > mContainers;
+    bool mPending;
+};
+
+} // anonymous namespace
+
+int main(int argc, char* argv[])
+{
+    if (argc != 3) {
+        std::cerr << "usage: " << argv[0] << " input.csv output.trace"
+                  << std::endl;
+        return 2;
+    }
+
+    try {
+        TraceWriter writer(argv[2]);
+        Parser parser(argv[1], writer);
+
+        parser.run();
+        writer.close();
+        std::cout << argv[2] << ": " << writer.header().transports
+                  << " transports, " << writer.header().containers
+                  << " containers, " << writer.header().locations
+                  << " locations" << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
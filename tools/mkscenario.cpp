@@ -0,0 +1,111 @@
+/**
+ * @file mkscenario.cpp
+ * @author The VLE Development Team
+ * See the AUTHORS or Authors.txt file
+ */
+
+/*
+ * Copyright (C) 2012 ULCO http://www.univ-littoral.fr
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Writes a vpz experiment with N platforms (see Scenario.hpp):
+ *
+ *   mkscenario [-r routes] [-i intensity] [-c capacity] [-d duration]
+ *              [-s seed] [-t timestep] platforms output.vpz
+ *
+ * routes is the number of platforms each platform sends its trucks to
+ * (2), intensity the transports arriving at each platform per time unit
+ * (1), capacity the containers per transport (2), duration the horizon
+ * of the experiment (200); views are only written with a timestep.
+ */
+
+#include <Scenario.hpp>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+using namespace logistics;
+
+namespace {
+
+void usage(const char* program)
+{
+    std::cerr << "usage: " << program << " [-r routes] [-i intensity] "
+              << "[-c capacity] [-d duration] [-s seed] [-t timestep] "
+              << "platforms output.vpz" << std::endl;
+    std::exit(2);
+}
+
+} // anonymous namespace
+
+int main(int argc, char* argv[])
+{
+    std::vector < std::string > arguments;
+    std::vector < std::pair < char, const char* > > options;
+
+    for (int i = 1; i < argc; ++i) {
+        if (argv[i][0] == '-' and std::strlen(argv[i]) == 2) {
+            if (i + 1 == argc or not std::strchr("ricdst", argv[i][1])) {
+                usage(argv[0]);
+            }
+            options.push_back(std::make_pair(argv[i][1], argv[i + 1]));
+            ++i;
+        } else {
+            arguments.push_back(argv[i]);
+        }
+    }
+    if (arguments.size() != 2) {
+        usage(argv[0]);
+    }
+
+    try {
+        Scenario scenario(std::atoi(arguments[0].c_str()));
+
+        for (unsigned int i = 0; i < options.size(); ++i) {
+            const char* value = options[i].second;
+
+            switch (options[i].first) {
+            case 'r':
+                scenario.routes(std::atoi(value));
+                break;
+            case 'i':
+                scenario.intensity(std::atof(value));
+                break;
+            case 'c':
+                scenario.capacity(std::atoi(value));
+                break;
+            case 'd':
+                scenario.duration(std::atof(value));
+                break;
+            case 's':
+                scenario.seed(std::strtoul(value, 0, 10));
+                break;
+            case 't':
+                scenario.timestep(std::atof(value));
+                break;
+            }
+        }
+        scenario.save(arguments[1]);
+        std::cout << arguments[1] << ": " << scenario.platforms()
+                  << " platforms, " << scenario.routes()
+                  << " routes per platform" << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
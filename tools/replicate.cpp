@@ -0,0 +1,272 @@
+/**
+ * @file replicate.cpp
+ * @author The VLE Development Team
+ * See the AUTHORS or Authors.txt file
+ */
+
+/*
+ * Copyright (C) 2012 ULCO http://www.univ-littoral.fr
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Runs R replications of an experiment in one process:
+ *
+ *   replicate [-r replications] [-j threads] [-s seed] experiment.vpz
+ *             output-directory
+ *
+ * The vpz is parsed once; each replication runs a copy of it with its
+ * own seed, drawn from the seed of the experiment (or -s), on a pool of
+ * threads sized to the machine (or -j). The models of a replication
+ * share nothing with the others but the location names (see
+ * Simulation.hpp). Each replication writes its views to its own
+ * directory; the files are then merged, in replication order, into one
+ * file per view in the output directory, whose rows start with the
+ * replication number. The experiment should use the file plugin for its
+ * outputs, as exp/example1.vpz does for the transit ("size", "waiting"...)
+ * and transport ("size", "wait") observables.
+ */
+
+#include <vle/manager/Manager.hpp>
+#include <vle/utils/Rand.hpp>
+#include <Experiment.hpp>
+#include <boost/bind.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <sstream>
+#include <vector>
+
+namespace fs = boost::filesystem;
+
+namespace {
+
+class Replications
+{
+public:
+    Replications(const vle::vpz::Vpz& experiment, const fs::path& output,
+                 unsigned int replications, boost::uint32_t seed) :
+        mExperiment(experiment), mOutput(output), mNext(0), mFailures(0)
+    {
+        vle::utils::Rand rand(seed);
+
+        // drawn before any run, so that the seed of each replication does
+        // not depend on the scheduling of the threads
+        for (unsigned int i = 0; i < replications; ++i) {
+            mSeeds.push_back(
+                rand.getInt(0, std::numeric_limits < int >::max()));
+        }
+    }
+
+    void run(unsigned int threads)
+    {
+        boost::thread_group workers;
+
+        for (unsigned int i = 0; i < threads; ++i) {
+            workers.create_thread(boost::bind(&Replications::work, this));
+        }
+        workers.join_all();
+    }
+
+    unsigned int failures() const
+    { return mFailures; }
+
+    /**
+     * Append the views of each replication to the files of the output
+     * directory, and remove the directories of the replications.
+     */
+    void merge()
+    {
+        std::map < std::string, std::ofstream* > files;
+
+        for (unsigned int i = 0; i < mSeeds.size(); ++i) {
+            fs::path directory = replication(i);
+            std::vector < fs::path > views = logistics::viewFiles(directory);
+
+            for (std::vector < fs::path >::const_iterator it = views.begin();
+                 it != views.end(); ++it) {
+                std::string name = it->filename().string();
+                std::ofstream*& file = files[name];
+                bool header = not file;
+
+                if (not file) {
+                    file = new std::ofstream(
+                        (mOutput / name).string().c_str());
+                }
+                append(*it, i, header, *file);
+            }
+            fs::remove_all(directory);
+        }
+        for (std::map < std::string, std::ofstream* >::iterator it =
+                 files.begin(); it != files.end(); ++it) {
+            delete it->second;
+        }
+    }
+
+private:
+    fs::path replication(unsigned int i) const
+    {
+        std::ostringstream name;
+
+        name << "replication-" << i;
+        return mOutput / name.str();
+    }
+
+    /**
+     * Next replication to run, or false when there is none left.
+     */
+    bool next(unsigned int& i)
+    {
+        boost::mutex::scoped_lock lock(mMutex);
+
+        if (mNext == mSeeds.size()) {
+            return false;
+        }
+        i = mNext++;
+        return true;
+    }
+
+    void work()
+    {
+        unsigned int i;
+
+        while (next(i)) {
+            vle::vpz::Vpz experiment(mExperiment);
+
+            experiment.project().experiment().setSeed(mSeeds[i]);
+            if (not logistics::runExperiment(experiment, replication(i))) {
+                boost::mutex::scoped_lock lock(mMutex);
+
+                ++mFailures;
+                std::cerr << "replication " << i << " (seed " << mSeeds[i]
+                          << ") failed" << std::endl;
+            }
+        }
+    }
+
+    /*
+     * The first line of a view file is its header, written once with a
+     * replication column; the separator is the one of the header.
+     */
+    static void append(const fs::path& path, unsigned int i, bool header,
+                       std::ostream& out)
+    {
+        std::ifstream in(path.string().c_str());
+        std::string line;
+
+        if (not std::getline(in, line)) {
+            return;
+        }
+
+        char separator = logistics::viewSeparator(line);
+
+        if (header) {
+            if (not line.empty() and line[0] == '#') {
+                out << "#replication" << separator << line.substr(1) << '\n';
+            } else {
+                out << "replication" << separator << line << '\n';
+            }
+        }
+        while (std::getline(in, line)) {
+            if (not line.empty()) {
+                out << i << separator << line << '\n';
+            }
+        }
+    }
+
+    const vle::vpz::Vpz& mExperiment;
+    fs::path mOutput;
+    std::vector < boost::uint32_t > mSeeds;
+    boost::mutex mMutex;
+    unsigned int mNext;
+    unsigned int mFailures;
+};
+
+void usage(const char* program)
+{
+    std::cerr << "usage: " << program << " [-r replications] [-j threads] "
+              << "[-s seed] experiment.vpz output-directory" << std::endl;
+    std::exit(2);
+}
+
+} // anonymous namespace
+
+int main(int argc, char* argv[])
+{
+    unsigned int replications = 10;
+    unsigned int threads =
+        std::max(1u, boost::thread::hardware_concurrency());
+    const char* seed = 0;
+    std::vector < std::string > arguments;
+
+    for (int i = 1; i < argc; ++i) {
+        if (argv[i][0] == '-' and std::strlen(argv[i]) == 2) {
+            if (i + 1 == argc) {
+                usage(argv[0]);
+            }
+            switch (argv[i][1]) {
+            case 'r':
+                replications = std::atoi(argv[++i]);
+                break;
+            case 'j':
+                threads = std::max(1, std::atoi(argv[++i]));
+                break;
+            case 's':
+                seed = argv[++i];
+                break;
+            default:
+                usage(argv[0]);
+            }
+        } else {
+            arguments.push_back(argv[i]);
+        }
+    }
+    if (arguments.size() != 2) {
+        usage(argv[0]);
+    }
+
+    vle::manager::init();
+
+    int status = 0;
+
+    try {
+        vle::vpz::Vpz experiment(arguments[0]);
+        fs::path output(arguments[1]);
+        Replications runner(experiment, output, replications,
+                            seed ? std::strtoul(seed, 0, 10) :
+                            experiment.project().experiment().seed());
+
+        fs::create_directories(output);
+        runner.run(std::min(threads, replications));
+        runner.merge();
+        std::cout << arguments[0] << ": " << replications - runner.failures()
+                  << " of " << replications << " replications run on "
+                  << std::min(threads, replications) << " threads"
+                  << std::endl;
+        status = runner.failures() ? 1 : 0;
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        status = 1;
+    }
+
+    vle::manager::finalize();
+    return status;
+}
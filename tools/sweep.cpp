@@ -0,0 +1,436 @@
+/**
+ * @file sweep.cpp
+ * @author The VLE Development Team
+ * See the AUTHORS or Authors.txt file
+ */
+
+/*
+ * Copyright (C) 2012 ULCO http://www.univ-littoral.fr
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Runs an experiment over a design of its condition ports:
+ *
+ *   sweep (-g levels | -l size | -q size) [-j threads] [-s seed]
+ *         experiment.vpz factors output.tsv
+ *
+ * factors lists the swept ports, one "condition port min max" line each
+ * (see Design.hpp), for instance
+ *
+ *   cond_A MinDuration 5 20
+ *   cond_arrival_generator MaxCapacity 1 4
+ *
+ * The design is a grid of levels values per factor (-g), a Latin
+ * hypercube (-l) or the first points of a Sobol sequence (-q); ports
+ * holding an integer in the vpz get rounded values. The points are run on
+ * a work-stealing pool (-j threads, the cores of the machine by default),
+ * all with the seed of the experiment so that they share their random
+ * numbers. As each run ends, one row is appended to output.tsv: the run,
+ * its status, the value of each factor, then the mean over time of each
+ * column of each view of the run.
+ */
+
+#include <vle/manager/Manager.hpp>
+#include <vle/value/Double.hpp>
+#include <vle/value/Integer.hpp>
+#include <Design.hpp>
+#include <Experiment.hpp>
+#include <boost/bind.hpp>
+#include <boost/function.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/scoped_array.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <map>
+
+namespace fs = boost::filesystem;
+
+using namespace logistics;
+
+namespace {
+
+/**
+ * Pool of threads running the tasks 0 to n - 1. Each thread starts with
+ * a contiguous share of the tasks, which it runs in order; a thread left
+ * without tasks steals the last one of another thread, so that a few
+ * long runs do not keep the other cores idle.
+ */
+class WorkStealingPool : private boost::noncopyable
+{
+public:
+    typedef boost::function < void (unsigned int) > Task;
+
+    WorkStealingPool(unsigned int threads) :
+        mThreads(threads), mQueues(new Queue[threads]), mSteals(0)
+    { }
+
+    void run(unsigned int tasks, const Task& task)
+    {
+        boost::thread_group workers;
+
+        for (unsigned int i = 0; i < tasks; ++i) {
+            mQueues[(unsigned long)i * mThreads / tasks].tasks.push_back(i);
+        }
+        for (unsigned int t = 0; t < mThreads; ++t) {
+            workers.create_thread(
+                boost::bind(&WorkStealingPool::work, this, t, task));
+        }
+        workers.join_all();
+    }
+
+    unsigned int steals() const
+    { return mSteals; }
+
+private:
+    struct Queue
+    {
+        boost::mutex mutex;
+        std::deque < unsigned int > tasks;
+    };
+
+    bool take(unsigned int t, unsigned int& task, unsigned int& steals)
+    {
+        {
+            boost::mutex::scoped_lock lock(mQueues[t].mutex);
+
+            if (not mQueues[t].tasks.empty()) {
+                task = mQueues[t].tasks.front();
+                mQueues[t].tasks.pop_front();
+                return true;
+            }
+        }
+        // no task is ever added, so one pass over the others is enough
+        for (unsigned int v = 1; v < mThreads; ++v) {
+            Queue& victim = mQueues[(t + v) % mThreads];
+            boost::mutex::scoped_lock lock(victim.mutex);
+
+            if (not victim.tasks.empty()) {
+                task = victim.tasks.back();
+                victim.tasks.pop_back();
+                ++steals;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void work(unsigned int t, Task task)
+    {
+        unsigned int i;
+        unsigned int steals = 0;
+
+        while (take(t, i, steals)) {
+            task(i);
+        }
+
+        boost::mutex::scoped_lock lock(mMutex);
+
+        mSteals += steals;
+    }
+
+    unsigned int mThreads;
+    boost::scoped_array < Queue > mQueues;
+    boost::mutex mMutex;
+    unsigned int mSteals;
+};
+
+/**
+ * Mean over time of each column of the views written in directory,
+ * named "view:column".
+ */
+std::map < std::string, double > summarize(const fs::path& directory)
+{
+    std::vector < fs::path > views = viewFiles(directory);
+    std::map < std::string, double > means;
+
+    for (std::vector < fs::path >::const_iterator it = views.begin();
+         it != views.end(); ++it) {
+        std::ifstream in(it->string().c_str());
+        std::string line, field;
+        std::vector < std::string > columns;
+
+        if (not std::getline(in, line)) {
+            continue;
+        }
+
+        char separator = viewSeparator(line);
+        std::istringstream header(line[0] == '#' ? line.substr(1) : line);
+
+        while (std::getline(header, field, separator)) {
+            columns.push_back(field);
+        }
+
+        std::vector < double > sums(columns.size(), 0.);
+        unsigned long rows = 0;
+
+        while (std::getline(in, line)) {
+            std::istringstream values(line);
+
+            if (line.empty()) {
+                continue;
+            }
+            for (unsigned int c = 0; c < columns.size() and
+                     std::getline(values, field, separator); ++c) {
+                sums[c] += std::strtod(field.c_str(), 0);
+            }
+            ++rows;
+        }
+        // the first column is the time
+        for (unsigned int c = 1; c < columns.size(); ++c) {
+            means[it->stem().string() + ":" + columns[c]] =
+                rows ? sums[c] / rows : 0.;
+        }
+    }
+    return means;
+}
+
+class Sweep
+{
+public:
+    Sweep(const vle::vpz::Vpz& experiment, const Factors& factors,
+          const Points& points, const fs::path& table) :
+        mExperiment(experiment), mFactors(factors), mPoints(points),
+        mTable(table), mOutput(table.string().c_str()), mHeader(false),
+        mFailures(0), mDone(0)
+    {
+        if (not mOutput) {
+            throw vle::utils::FileError("cannot write " + table.string());
+        }
+    }
+
+    void run(unsigned int threads)
+    {
+        WorkStealingPool pool(threads);
+
+        pool.run(mPoints.size(), boost::bind(&Sweep::point, this, _1));
+        if (not mHeader) {
+            header(std::map < std::string, double >());
+        }
+        std::cout << mTable.string() << ": " << mDone - mFailures << " of "
+                  << mPoints.size() << " runs on " << threads
+                  << " threads, " << pool.steals() << " steals" << std::endl;
+    }
+
+    unsigned int failures() const
+    { return mFailures; }
+
+private:
+    /**
+     * Row of a failed run waiting for the header.
+     */
+    struct Row
+    {
+        unsigned int run;
+        std::vector < double > values;
+    };
+
+    void point(unsigned int i)
+    {
+        vle::vpz::Vpz experiment(mExperiment);
+        std::vector < double > values(mFactors.size());
+        std::ostringstream name;
+
+        name << mTable.stem().string() << "-run-" << i;
+
+        fs::path directory = mTable.parent_path() / name.str();
+
+        for (unsigned int f = 0; f < mFactors.size(); ++f) {
+            vle::vpz::Condition& condition =
+                experiment.project().experiment().conditions().get(
+                    mFactors[f].condition);
+
+            values[f] = mFactors[f].value(mPoints[i][f]);
+            if (condition.firstValue(mFactors[f].port).isInteger()) {
+                values[f] = std::floor(values[f] + .5);
+                condition.setValueToPort(mFactors[f].port,
+                                         vle::value::Integer(values[f]));
+            } else {
+                condition.setValueToPort(mFactors[f].port,
+                                         vle::value::Double(values[f]));
+            }
+        }
+
+        bool success = runExperiment(experiment, directory);
+        std::map < std::string, double > means = summarize(directory);
+
+        fs::remove_all(directory);
+        write(i, success, values, means);
+    }
+
+    /*
+     * The columns of the views are those of the first successful run to
+     * end; the rows of the runs that failed before it are kept until
+     * then. The rows are otherwise appended and flushed in the order the
+     * runs end.
+     */
+    void write(unsigned int i, bool success,
+               const std::vector < double >& values,
+               const std::map < std::string, double >& means)
+    {
+        boost::mutex::scoped_lock lock(mMutex);
+
+        ++mDone;
+        if (not success) {
+            ++mFailures;
+        }
+        if (not mHeader and success) {
+            header(means);
+        }
+        if (mHeader) {
+            row(i, success, values, means);
+        } else {
+            Row pending = { i, values };
+
+            mPending.push_back(pending);
+        }
+    }
+
+    /**
+     * Write the header, without view columns if no run succeeded, then
+     * the rows kept until then.
+     */
+    void header(const std::map < std::string, double >& means)
+    {
+        mOutput << "run\tstatus";
+        for (unsigned int f = 0; f < mFactors.size(); ++f) {
+            mOutput << '\t' << mFactors[f].condition << '.'
+                    << mFactors[f].port;
+        }
+        for (std::map < std::string, double >::const_iterator it =
+                 means.begin(); it != means.end(); ++it) {
+            mColumns.push_back(it->first);
+            mOutput << '\t' << it->first;
+        }
+        mOutput << '\n';
+        mHeader = true;
+        for (std::vector < Row >::const_iterator it = mPending.begin();
+             it != mPending.end(); ++it) {
+            row(it->run, false, it->values,
+                std::map < std::string, double >());
+        }
+        mPending.clear();
+    }
+
+    void row(unsigned int i, bool success,
+             const std::vector < double >& values,
+             const std::map < std::string, double >& means)
+    {
+        mOutput << i << '\t' << (success ? "ok" : "failed");
+        for (unsigned int f = 0; f < values.size(); ++f) {
+            mOutput << '\t' << values[f];
+        }
+        for (unsigned int c = 0; c < mColumns.size(); ++c) {
+            std::map < std::string, double >::const_iterator it =
+                means.find(mColumns[c]);
+
+            if (it == means.end()) {
+                mOutput << "\tNA";
+            } else {
+                mOutput << '\t' << it->second;
+            }
+        }
+        mOutput << std::endl;
+    }
+
+    const vle::vpz::Vpz& mExperiment;
+    const Factors& mFactors;
+    const Points& mPoints;
+    fs::path mTable;
+    std::ofstream mOutput;
+    std::vector < std::string > mColumns;
+    std::vector < Row > mPending;
+    bool mHeader;
+    boost::mutex mMutex;
+    unsigned int mFailures;
+    unsigned int mDone;
+};
+
+void usage(const char* program)
+{
+    std::cerr << "usage: " << program << " (-g levels | -l size | -q size) "
+              << "[-j threads] [-s seed] experiment.vpz factors output.tsv"
+              << std::endl;
+    std::exit(2);
+}
+
+} // anonymous namespace
+
+int main(int argc, char* argv[])
+{
+    char design = 0;
+    unsigned int size = 0;
+    unsigned int threads =
+        std::max(1u, boost::thread::hardware_concurrency());
+    boost::uint32_t seed = 1;
+    std::vector < std::string > arguments;
+
+    for (int i = 1; i < argc; ++i) {
+        if (argv[i][0] == '-' and std::strlen(argv[i]) == 2) {
+            if (i + 1 == argc) {
+                usage(argv[0]);
+            }
+            switch (argv[i][1]) {
+            case 'g':
+            case 'l':
+            case 'q':
+                design = argv[i][1];
+                size = std::atoi(argv[++i]);
+                break;
+            case 'j':
+                threads = std::max(1, std::atoi(argv[++i]));
+                break;
+            case 's':
+                seed = std::strtoul(argv[++i], 0, 10);
+                break;
+            default:
+                usage(argv[0]);
+            }
+        } else {
+            arguments.push_back(argv[i]);
+        }
+    }
+    if (arguments.size() != 3 or not design) {
+        usage(argv[0]);
+    }
+
+    vle::manager::init();
+
+    int status = 0;
+
+    try {
+        vle::vpz::Vpz experiment(arguments[0]);
+        Factors factors = readFactors(arguments[1]);
+        Points points = design == 'g' ? gridDesign(factors.size(), size) :
+            design == 'l' ? latinHypercubeDesign(factors.size(), size, seed) :
+            sobolDesign(factors.size(), size);
+        Sweep sweep(experiment, factors, points, fs::path(arguments[2]));
+
+        sweep.run(std::max(1u, std::min(threads,
+                                        (unsigned int)points.size())));
+        status = sweep.failures() ? 1 : 0;
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        status = 1;
+    }
+
+    vle::manager::finalize();
+    return status;
+}